@@ -0,0 +1,2993 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/sysmacros.h>
+
+#include "joystick.h"
+#include "joystick_map.h"
+#include "joystick_map_packed.h"
+#include "joystick_map_sparse.h"
+#include "joystick_map_fixed.h"
+#include "joystick_map_ps3.h"
+#include "joystick_curve.h"
+#include "joystick_device_set.h"
+#include "joystick_dynamic.h"
+#include "joystick_evdev.h"
+#include "joystick_filter.h"
+#include "joystick_publish.h"
+#include "joystick_q15.h"
+#include "joystick_reader.h"
+#include "joystick_record.h"
+#include "joystick_shm.h"
+#include "joystick_source.h"
+#include "joystick_state.h"
+#include "joystick_stats.h"
+#include "joystick_sysfs.h"
+#include "joystick_wait.h"
+
+
+/*
+ * Number of recorded frames mapped per measurement.
+ */
+
+#define BENCH_FRAMES (1 << 18)
+
+/*
+ * Each measurement is repeated and the fastest run is reported.
+ */
+
+#define BENCH_REPEAT 5
+
+/*
+ * Largest difference allowed between incremental and full translate,
+ * for inputs and elements in [-1, 1].
+ */
+
+#define BENCH_INCREMENTAL_ERROR 1e-4f
+
+/*
+ * Largest difference allowed between a curve table and the curve.
+ */
+
+#define BENCH_CURVE_ERROR 1e-6
+
+/*
+ * Largest difference allowed between a filter and its double precision
+ * reference.
+ */
+
+#define BENCH_FILTER_ERROR 1e-4
+
+/*
+ * Frames per size in the translate sweep.
+ */
+
+#define BENCH_SWEEP_FRAMES (1 << 16)
+
+/*
+ * Events fed through the device per poll measurement.
+ */
+
+#define BENCH_POLL_EVENTS (1 << 20)
+
+/*
+ * Scans per identify measurement.
+ */
+
+#define BENCH_IDENTIFY_REPEAT 50
+#define BENCH_IDENTIFY_DEVICES 64
+
+/*
+ * Events timed one by one from write to translated output.
+ */
+
+#define BENCH_LATENCY_EVENTS 20000
+#define BENCH_LATENCY_WARMUP 100
+
+/*
+ * Print results as one JSON object per line, set by -j.
+ */
+
+static int bench_json = 0;
+
+
+static double bench_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec*1e-9;
+}
+
+static float bench_random(void)
+{
+	return (float)rand()/(float)RAND_MAX*2.0f - 1.0f;
+}
+
+/*
+ * Print one result.
+ *
+ * @param params Parameters of the measurement as space separated key=number pairs.
+ *
+ * @param metric Name of the measured quantity, with its unit.
+ */
+static void bench_emit(const char *name, const char *params, const char *metric, double value)
+{
+	if(!bench_json)
+	{
+		printf("%-28s %-40s %s=%.1f\n", name, params, metric, value);
+		return;
+	}
+
+	printf("{\"name\":\"%s\",\"params\":{", name);
+
+	const char *param = params;
+	while(*param != '\0')
+	{
+		const size_t key_length = strcspn(param, "=");
+		const size_t value_length = strcspn(param + key_length + 1, " ");
+
+		printf("%s\"%.*s\":%.*s", param == params ? "" : ",", (int)key_length, param, (int)value_length, param + key_length + 1);
+
+		param = param + key_length + 1 + value_length;
+		param = param + strspn(param, " ");
+	}
+
+	printf("},\"metric\":\"%s\",\"value\":%.1f}\n", metric, value);
+}
+
+static void bench_report(const char *name, uint32_t input_count, uint32_t output_count, double seconds)
+{
+	char params[64];
+	snprintf(params, sizeof params, "inputs=%u outputs=%u frames=%d", (unsigned)input_count, (unsigned)output_count, BENCH_FRAMES);
+	bench_emit(name, params, "fps", (double)BENCH_FRAMES/seconds);
+}
+
+/*
+ * Map with random elements, each nonzero with the given percent chance.
+ */
+static void bench_map_random(struct joystick_map *map, uint32_t input_count, uint32_t output_count, int density)
+{
+	joystick_map_create(map, input_count, output_count);
+
+	for(uint32_t j = 0; j < input_count; j++)
+	{
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < output_count; i++){
+			output_scale[i] = rand() % 100 < density ? bench_random() : 0.0f;
+		}
+
+		joystick_map_transform(map, j, output_scale, output_count);
+	}
+
+	for(uint32_t i = 0; i < output_count; i++){
+		map->map_offset[i] = bench_random();
+	}
+}
+
+/*
+ * Every packed kernel the CPU supports must give the same results as
+ * joystick_map_translate, bit for bit, over random maps and inputs.
+ */
+static void bench_check_packed(void)
+{
+	const enum joystick_map_kernel kernels[] = {
+		JOYSTICK_MAP_KERNEL_SCALAR,
+		JOYSTICK_MAP_KERNEL_SSE2,
+		JOYSTICK_MAP_KERNEL_AVX2,
+		JOYSTICK_MAP_KERNEL_NEON,
+	};
+
+	static struct joystick_map map;
+
+	for(int m = 0; m < 64; m++)
+	{
+		const uint32_t input_count = 1 + (uint32_t)rand() % JOYSTICK_MAP_INPUT_MAX;
+		const uint32_t output_count = 1 + (uint32_t)rand() % JOYSTICK_MAP_OUTPUT_MAX;
+		bench_map_random(&map, input_count, output_count, 100);
+
+		for(size_t k = 0; k < sizeof kernels/sizeof kernels[0]; k++)
+		{
+			struct joystick_map_packed packed;
+			if(joystick_map_pack_kernel(&map, &packed, kernels[k]) < 0){
+				/* Not supported by this CPU. */
+				continue;
+			}
+
+			for(int f = 0; f < 256; f++)
+			{
+				float input[JOYSTICK_MAP_INPUT_MAX];
+				for(uint32_t j = 0; j < input_count; j++){
+					input[j] = bench_random();
+				}
+
+				float expected[JOYSTICK_MAP_OUTPUT_MAX];
+				float output[JOYSTICK_MAP_OUTPUT_MAX];
+
+				joystick_map_translate_array(&map, input, expected, output_count);
+				joystick_map_packed_translate_array(&packed, input, output, output_count);
+
+				if(memcmp(expected, output, output_count*sizeof(float)) != 0){
+					fprintf(stderr, "joystick_map_packed_translate_array(): kernel %d mismatch, inputs=%u outputs=%u \n", (int)kernels[k], (unsigned)input_count, (unsigned)output_count);
+					exit(EXIT_FAILURE);
+				}
+			}
+
+			joystick_map_packed_destroy(&packed);
+		}
+
+		joystick_map_destroy(&map);
+	}
+}
+
+/*
+ * Sparse and compiled form of the map against joystick_map_translate,
+ * bit for bit. Destroys the map.
+ *
+ * @param form Form compile must choose, 0 for any.
+ */
+static void bench_check_sparse_map(struct joystick_map *map, enum joystick_map_form form)
+{
+	struct joystick_map_sparse sparse;
+	struct joystick_map_compiled compiled;
+	if(joystick_map_sparse_create(map, &sparse) < 0 || joystick_map_compile(map, &compiled) < 0){
+		fprintf(stderr, "joystick_map_sparse_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	if(form != 0 && compiled.compiled_form != form){
+		fprintf(stderr, "joystick_map_compile(): form %d, expected %d \n", (int)compiled.compiled_form, (int)form);
+		exit(EXIT_FAILURE);
+	}
+
+	const uint32_t output_count = map->map_output_count;
+
+	for(int f = 0; f < 256; f++)
+	{
+		struct joystick_input_value input_value;
+		memset(&input_value, 0, sizeof input_value);
+
+		for(uint32_t j = 0; j < map->map_input_count; j++){
+			input_value.joystick_axis_value[j] = bench_random();
+		}
+
+		float expected[JOYSTICK_MAP_OUTPUT_MAX];
+		float output[JOYSTICK_MAP_OUTPUT_MAX];
+		float output_compiled[JOYSTICK_MAP_OUTPUT_MAX];
+
+		joystick_map_translate(map, &input_value, expected, output_count);
+		joystick_map_sparse_translate(&sparse, &input_value, output, output_count);
+		joystick_map_compiled_translate(&compiled, &input_value, output_compiled, output_count);
+
+		if(memcmp(expected, output, output_count*sizeof(float)) != 0 || memcmp(expected, output_compiled, output_count*sizeof(float)) != 0){
+			fprintf(stderr, "joystick_map_sparse_translate(): mismatch, inputs=%u outputs=%u \n", (unsigned)map->map_input_count, (unsigned)output_count);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	joystick_map_compiled_destroy(&compiled);
+	joystick_map_sparse_destroy(&sparse);
+	joystick_map_destroy(map);
+}
+
+/*
+ * Sparse maps from empty to full up to the largest map, and on both
+ * sides of the JOYSTICK_MAP_SPARSE_RATIO choice.
+ */
+static void bench_check_sparse(void)
+{
+	static struct joystick_map map;
+
+	const int densities[] = {0, 5, 10, 25, 50, 100};
+	const uint32_t sizes[][2] = {
+		{1, 1},
+		{6, 6},
+		{13, 7},
+		{JOYSTICK_MAP_INPUT_MAX, JOYSTICK_MAP_OUTPUT_MAX},
+	};
+
+	for(size_t i = 0; i < sizeof sizes/sizeof sizes[0]; i++)
+	{
+		for(size_t k = 0; k < sizeof densities/sizeof densities[0]; k++){
+			bench_map_random(&map, sizes[i][0], sizes[i][1], densities[k]);
+			bench_check_sparse_map(&map, 0);
+		}
+	}
+
+	/* 10x10 maps with 10 and 11 nonzero elements, just sparse and just packed. */
+	const uint32_t boundary_count = 10*10/JOYSTICK_MAP_SPARSE_RATIO;
+
+	for(uint32_t nonzero_count = boundary_count; nonzero_count <= boundary_count + 1; nonzero_count++)
+	{
+		bench_map_random(&map, 10, 10, 0);
+
+		for(uint32_t e = 0; e < nonzero_count; e++){
+			map.map_matrix[e%10][e/10] = bench_random() + 2.0f;
+		}
+
+		bench_check_sparse_map(&map, nonzero_count <= boundary_count ? JOYSTICK_MAP_FORM_SPARSE : JOYSTICK_MAP_FORM_PACKED);
+	}
+}
+
+static void bench_translate_batch(uint32_t input_count, uint32_t output_count, size_t thread_count)
+{
+	static struct joystick_map map;
+	joystick_map_create(&map, input_count, output_count);
+
+	for(uint32_t j = 0; j < input_count; j++)
+	{
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < output_count; i++){
+			output_scale[i] = bench_random();
+		}
+
+		joystick_map_transform(&map, j, output_scale, output_count);
+	}
+
+	struct joystick_map_packed packed;
+	if(joystick_map_pack(&map, &packed) < 0){
+		fprintf(stderr, "joystick_map_pack(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value *input_values = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value));
+	float *input_soa = calloc((size_t)BENCH_FRAMES*input_count, sizeof(float));
+	float *output = calloc((size_t)BENCH_FRAMES*output_count, sizeof(float));
+
+	if(input_values == NULL || input_soa == NULL || output == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			float v = bench_random();
+			input_values[f].joystick_axis_value[j] = v;
+			input_soa[j*BENCH_FRAMES + f] = v;
+		}
+	}
+
+	/* Every batch path gives the same results as translate, frame by frame. */
+	float *expected = calloc((size_t)BENCH_FRAMES*output_count, sizeof(float));
+	if(expected == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++){
+		joystick_map_translate(&map, &input_values[f], &expected[f*output_count], output_count);
+	}
+
+	const size_t output_size = (size_t)BENCH_FRAMES*output_count*sizeof(float);
+
+	memset(output, 0, output_size);
+	joystick_map_packed_translate_batch(&packed, input_values, BENCH_FRAMES, output);
+	if(memcmp(expected, output, output_size) != 0){
+		fprintf(stderr, "joystick_map_packed_translate_batch(): mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(output, 0, output_size);
+	joystick_map_packed_translate_batch_soa(&packed, input_soa, BENCH_FRAMES, output);
+	if(memcmp(expected, output, output_size) != 0){
+		fprintf(stderr, "joystick_map_packed_translate_batch_soa(): mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	memset(output, 0, output_size);
+	joystick_map_packed_translate_batch_parallel(&packed, input_values, BENCH_FRAMES, output, thread_count);
+	if(memcmp(expected, output, output_size) != 0){
+		fprintf(stderr, "joystick_map_packed_translate_batch_parallel(): mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	free(expected);
+
+	double best[4] = {1e9, 1e9, 1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate(&map, &input_values[f], &output[f*output_count], output_count);
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		joystick_map_packed_translate_batch(&packed, input_values, BENCH_FRAMES, output);
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+
+		t = bench_now();
+		joystick_map_packed_translate_batch_soa(&packed, input_soa, BENCH_FRAMES, output);
+		t = bench_now() - t;
+		best[2] = t < best[2] ? t : best[2];
+
+		t = bench_now();
+		joystick_map_packed_translate_batch_parallel(&packed, input_values, BENCH_FRAMES, output, thread_count);
+		t = bench_now() - t;
+		best[3] = t < best[3] ? t : best[3];
+	}
+
+	bench_report("translate_batch_baseline", input_count, output_count, best[0]);
+	bench_report("translate_batch", input_count, output_count, best[1]);
+	bench_report("translate_batch_soa", input_count, output_count, best[2]);
+	bench_report("translate_batch_parallel", input_count, output_count, best[3]);
+
+	free(output);
+	free(input_soa);
+	free(input_values);
+
+	joystick_map_packed_destroy(&packed);
+	joystick_map_destroy(&map);
+}
+
+/*
+ * Typical stick input, two axes change every frame.
+ */
+static void bench_translate_incremental(uint32_t input_count, uint32_t output_count)
+{
+	static struct joystick_map map;
+	joystick_map_create(&map, input_count, output_count);
+
+	for(uint32_t j = 0; j < input_count; j++)
+	{
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < output_count; i++){
+			output_scale[i] = bench_random();
+		}
+
+		joystick_map_transform(&map, j, output_scale, output_count);
+	}
+
+	struct joystick_input_value *input_values = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value));
+	if(input_values == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		if(f > 0){
+			input_values[f] = input_values[f - 1];
+		}
+
+		input_values[f].joystick_axis_changed = 0;
+		for(int k = 0; k < 2; k++)
+		{
+			uint32_t j = (uint32_t)rand() % input_count;
+			input_values[f].joystick_axis_value[j] = bench_random();
+			input_values[f].joystick_axis_changed |= 1u << j;
+		}
+	}
+
+	float output[JOYSTICK_MAP_OUTPUT_MAX];
+
+	/*
+	 * Same results as a full translate within BENCH_INCREMENTAL_ERROR,
+	 * every frame, so the error does not build up between recomputes.
+	 */
+	{
+		struct joystick_map_incremental incremental;
+		joystick_map_incremental_create(&incremental, JOYSTICK_MAP_INCREMENTAL_REFRESH);
+
+		float error_max = 0.0f;
+
+		for(size_t f = 0; f < BENCH_FRAMES; f++)
+		{
+			float expected[JOYSTICK_MAP_OUTPUT_MAX];
+			joystick_map_translate(&map, &input_values[f], expected, output_count);
+			joystick_map_translate_incremental(&map, &incremental, &input_values[f], output, output_count);
+
+			for(uint32_t i = 0; i < output_count; i++){
+				const float error = fabsf(expected[i] - output[i]);
+				error_max = error > error_max ? error : error_max;
+			}
+		}
+
+		if(!(error_max <= BENCH_INCREMENTAL_ERROR)){
+			fprintf(stderr, "joystick_map_translate_incremental(): error %g \n", (double)error_max);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	double best[2] = {1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate(&map, &input_values[f], output, output_count);
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		struct joystick_map_incremental incremental;
+		joystick_map_incremental_create(&incremental, JOYSTICK_MAP_INCREMENTAL_REFRESH);
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate_incremental(&map, &incremental, &input_values[f], output, output_count);
+		}
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+	}
+
+	bench_report("translate_incremental_baseline", input_count, output_count, best[0]);
+	bench_report("translate_incremental", input_count, output_count, best[1]);
+
+	free(input_values);
+	joystick_map_destroy(&map);
+}
+
+/*
+ * Packed against sparse form for a map with the given percent of nonzero elements.
+ */
+static void bench_translate_sparse(uint32_t input_count, uint32_t output_count, int density)
+{
+	static struct joystick_map map;
+	joystick_map_create(&map, input_count, output_count);
+
+	for(uint32_t j = 0; j < input_count; j++)
+	{
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < output_count; i++){
+			output_scale[i] = rand() % 100 < density ? bench_random() : 0.0f;
+		}
+
+		joystick_map_transform(&map, j, output_scale, output_count);
+	}
+
+	struct joystick_map_packed packed;
+	struct joystick_map_sparse sparse;
+	if(joystick_map_pack(&map, &packed) < 0 || joystick_map_sparse_create(&map, &sparse) < 0){
+		fprintf(stderr, "joystick_map_pack(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value *input_values = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value));
+	if(input_values == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		for(uint32_t j = 0; j < input_count; j++){
+			input_values[f].joystick_axis_value[j] = bench_random();
+		}
+	}
+
+	float output[JOYSTICK_MAP_OUTPUT_MAX];
+	double best[2] = {1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_packed_translate(&packed, &input_values[f], output, output_count);
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_sparse_translate(&sparse, &input_values[f], output, output_count);
+		}
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+	}
+
+	char name[64];
+	snprintf(name, sizeof name, "translate_packed_%d%%", density);
+	bench_report(name, input_count, output_count, best[0]);
+	snprintf(name, sizeof name, "translate_sparse_%d%%", density);
+	bench_report(name, input_count, output_count, best[1]);
+
+	free(input_values);
+
+	joystick_map_sparse_destroy(&sparse);
+	joystick_map_packed_destroy(&packed);
+	joystick_map_destroy(&map);
+}
+
+/*
+ * PS3 sticks to a 6 channel application, left stick mixed into two channels.
+ */
+static const float bench_ps3_matrix[JOYSTICK_PS3_AXIS_LENGTH][6] = {
+	[JOYSTICK_PS3_AXIS_LEFT_X] = {1.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f},
+	[JOYSTICK_PS3_AXIS_LEFT_Y] = {0.0f, -1.0f, 0.0f, 0.5f, 0.0f, 0.0f},
+	[JOYSTICK_PS3_AXIS_RIGHT_X] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f},
+	[JOYSTICK_PS3_AXIS_RIGHT_Y] = {0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f},
+	[JOYSTICK_PS3_AXIS_RIGHT_BOTTOM] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f},
+};
+
+static const float bench_ps3_offset[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f};
+
+JOYSTICK_MAP_FIXED_DEFINE(bench_ps3_translate, JOYSTICK_PS3_AXIS_LENGTH, 6, bench_ps3_matrix, bench_ps3_offset)
+
+static const float bench_8x4_matrix[8][4] = {
+	{1.0f, 0.0f, 0.0f, 0.0f},
+	{0.0f, 1.0f, 0.0f, 0.0f},
+	{0.0f, 0.0f, 1.0f, 0.0f},
+	{0.0f, 0.0f, 0.0f, 1.0f},
+	{0.25f, 0.25f, 0.0f, 0.0f},
+	{0.0f, 0.0f, 0.25f, 0.25f},
+};
+
+static const float bench_8x4_offset[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+JOYSTICK_MAP_FIXED_DEFINE(bench_8x4_translate, 8, 4, bench_8x4_matrix, bench_8x4_offset)
+
+/*
+ * Generated fixed shape maps against the generic map with the same elements.
+ */
+static void bench_translate_fixed(void)
+{
+	static struct joystick_map map_ps3;
+	static struct joystick_map map_8x4;
+	bench_ps3_translate_map(&map_ps3);
+	bench_8x4_translate_map(&map_8x4);
+
+	struct joystick_input_value *input_values = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value));
+	if(input_values == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		for(uint32_t j = 0; j < 8; j++){
+			input_values[f].joystick_axis_value[j] = bench_random();
+		}
+	}
+
+	/* Same results as the generic path. */
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		float expected[6];
+		float output[6];
+
+		joystick_map_translate(&map_ps3, &input_values[f], expected, 6);
+		bench_ps3_translate(&input_values[f], output);
+		if(memcmp(expected, output, sizeof output) != 0){
+			fprintf(stderr, "bench_ps3_translate(): mismatch \n");
+			exit(EXIT_FAILURE);
+		}
+
+		joystick_map_translate(&map_8x4, &input_values[f], expected, 4);
+		bench_8x4_translate(&input_values[f], output);
+		if(memcmp(expected, output, 4*sizeof(float)) != 0){
+			fprintf(stderr, "bench_8x4_translate(): mismatch \n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Accumulated so the fixed maps are not optimized out. */
+	volatile float sink = 0.0f;
+	float output[6];
+	double best[4] = {1e9, 1e9, 1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate(&map_ps3, &input_values[f], output, 6);
+			sink = sink + output[0];
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			bench_ps3_translate(&input_values[f], output);
+			sink = sink + output[0];
+		}
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate(&map_8x4, &input_values[f], output, 4);
+			sink = sink + output[0];
+		}
+		t = bench_now() - t;
+		best[2] = t < best[2] ? t : best[2];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			bench_8x4_translate(&input_values[f], output);
+			sink = sink + output[0];
+		}
+		t = bench_now() - t;
+		best[3] = t < best[3] ? t : best[3];
+	}
+
+	bench_report("translate_fixed_ps3_baseline", JOYSTICK_PS3_AXIS_LENGTH, 6, best[0]);
+	bench_report("translate_fixed_ps3", JOYSTICK_PS3_AXIS_LENGTH, 6, best[1]);
+	bench_report("translate_fixed_baseline", 8, 4, best[2]);
+	bench_report("translate_fixed", 8, 4, best[3]);
+
+	free(input_values);
+
+	joystick_map_destroy(&map_8x4);
+	joystick_map_destroy(&map_ps3);
+}
+
+static float bench_curve_square(float magnitude, void *function_arg)
+{
+	(void)function_arg;
+	return magnitude*magnitude;
+}
+
+/*
+ * Value of the table of axis 0 for a raw value.
+ */
+static float bench_curve_table(const struct joystick_curve *curve, int16_t value)
+{
+	return joystick_curve_apply(curve, 0, value);
+}
+
+/*
+ * Curves of bench_check_curve written out in double precision.
+ */
+static double bench_curve_reference(size_t config, int16_t value)
+{
+	const double x = value < -INT16_MAX ? -1.0 : (double)value/INT16_MAX;
+	const double m = fabs(x);
+	double y;
+
+	switch(config)
+	{
+		case 1:
+			y = m <= 0.1 ? 0.0 : pow((m - 0.1)/0.9, 3.0);
+			break;
+
+		case 2:
+			y = m/0.8 < 1.0 ? m/0.8 : 1.0;
+			break;
+
+		case 4:
+			y = m*m;
+			break;
+
+		default:
+			y = m;
+			break;
+	}
+
+	y = x < 0.0 ? -y : y;
+
+	return config == 3 ? -y : y;
+}
+
+/*
+ * Tables must hold the curve written out in double precision for every
+ * raw value, within BENCH_CURVE_ERROR, and the value of
+ * joystick_curve_evaluate at the same index. The curves must meet their
+ * endpoints.
+ */
+static void bench_check_curve(void)
+{
+	struct joystick_curve_config configs[5];
+
+	/* Linear, deadzone with expo, saturation, inverted, custom function. */
+	for(size_t c = 0; c < 5; c++){
+		joystick_curve_config_default(&configs[c]);
+	}
+
+	configs[1].config_deadzone = 0.1f;
+	configs[1].config_expo = 1.0f;
+	configs[2].config_saturation = 0.8f;
+	configs[3].config_invert = 1;
+	configs[4].config_function = bench_curve_square;
+
+	struct joystick_curve curve;
+	joystick_curve_create(&curve);
+
+	for(size_t c = 0; c < 5; c++)
+	{
+		if(joystick_curve_set(&curve, 0, &configs[c]) < 0){
+			fprintf(stderr, "joystick_curve_set(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		for(int32_t v = INT16_MIN; v <= INT16_MAX; v++)
+		{
+			const double expected = bench_curve_reference(c, (int16_t)v);
+			const float table = bench_curve_table(&curve, (int16_t)v);
+
+			if(!(fabs(expected - (double)table) <= BENCH_CURVE_ERROR)){
+				fprintf(stderr, "joystick_curve_set(): config %zu value %d is %g, expected %g \n", c, (int)v, (double)table, expected);
+				exit(EXIT_FAILURE);
+			}
+
+			/* The table is indexed by the raw value. */
+			if(table != joystick_curve_evaluate(&configs[c], (int16_t)v)){
+				fprintf(stderr, "joystick_curve_set(): config %zu value %d at wrong index \n", c, (int)v);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		const float full = bench_curve_table(&curve, INT16_MAX);
+		const float full_negative = bench_curve_table(&curve, INT16_MIN);
+		const float center = bench_curve_table(&curve, 0);
+
+		int endpoints = center == 0.0f
+		&& full == (configs[c].config_invert ? -1.0f : 1.0f)
+		&& full_negative == -full;
+
+		switch(c)
+		{
+			case 1:
+				/* Zero up to the deadzone, then rising from zero. */
+				endpoints = endpoints
+				&& bench_curve_table(&curve, (int16_t)(0.1f*INT16_MAX)) == 0.0f
+				&& bench_curve_table(&curve, (int16_t)(-0.1f*INT16_MAX)) == 0.0f
+				&& bench_curve_table(&curve, (int16_t)(0.11f*INT16_MAX)) > 0.0f
+				&& bench_curve_table(&curve, (int16_t)(0.11f*INT16_MAX)) < 1e-5f
+				/* Cubic, half way out is 1/8. */
+				&& fabsf(bench_curve_table(&curve, (int16_t)(0.55f*INT16_MAX)) - 0.125f) < 1e-3f;
+				break;
+
+			case 2:
+				/* Full output from the saturation point. */
+				endpoints = endpoints
+				&& bench_curve_table(&curve, (int16_t)(0.81f*INT16_MAX)) == 1.0f
+				&& bench_curve_table(&curve, (int16_t)(-0.81f*INT16_MAX)) == -1.0f
+				&& bench_curve_table(&curve, (int16_t)(0.4f*INT16_MAX)) < 0.51f;
+				break;
+
+			case 3:
+				endpoints = endpoints
+				&& bench_curve_table(&curve, (int16_t)(0.5f*INT16_MAX)) < 0.0f;
+				break;
+
+			case 4:
+				endpoints = endpoints
+				&& fabsf(bench_curve_table(&curve, (int16_t)(0.5f*INT16_MAX)) - 0.25f) < 1e-3f;
+				break;
+		}
+
+		if(!endpoints){
+			fprintf(stderr, "joystick_curve_set(): config %zu endpoints wrong \n", c);
+			exit(EXIT_FAILURE);
+		}
+
+		joystick_curve_clear(&curve, 0);
+	}
+
+	joystick_curve_destroy(&curve);
+}
+
+/*
+ * Response curve per axis value, computed against looked up.
+ */
+static void bench_curve(void)
+{
+	bench_check_curve();
+
+	struct joystick_curve_config config;
+	joystick_curve_config_default(&config);
+	config.config_deadzone = 0.05f;
+	config.config_expo = 0.4f;
+
+	struct joystick_curve curve;
+	joystick_curve_create(&curve);
+	if(joystick_curve_set(&curve, 0, &config) < 0){
+		fprintf(stderr, "joystick_curve_set(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	int16_t *values = calloc(BENCH_FRAMES, sizeof(int16_t));
+	if(values == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++){
+		values[f] = (int16_t)(bench_random()*(float)INT16_MAX);
+	}
+
+	volatile float sink = 0.0f;
+	double best[2] = {1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			sink = sink + joystick_curve_evaluate(&config, values[f]);
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			sink = sink + joystick_curve_apply(&curve, 0, values[f]);
+		}
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+	}
+
+	bench_report("curve_evaluate", 1, 1, best[0]);
+	bench_report("curve_table", 1, 1, best[1]);
+
+	free(values);
+	joystick_curve_destroy(&curve);
+}
+
+/*
+ * Double precision filter, stepped one millisecond at a time.
+ */
+struct bench_filter
+{
+	enum joystick_filter_type filter_type;
+	double filter_tau;
+	double filter_beta;
+	double filter_tau_derivative;
+	double filter_b[3];
+	double filter_a[3];
+
+	double filter_y;
+	double filter_dx;
+	double filter_x;
+	double filter_state[2];
+};
+
+static double bench_filter_biquad(struct bench_filter *filter, double x)
+{
+	const double y = filter->filter_b[0]*x + filter->filter_state[0];
+	filter->filter_state[0] = filter->filter_b[1]*x - filter->filter_a[1]*y + filter->filter_state[1];
+	filter->filter_state[1] = filter->filter_b[2]*x - filter->filter_a[2]*y;
+
+	return y;
+}
+
+static double bench_filter_start(struct bench_filter *filter, double x)
+{
+	filter->filter_y = x;
+	filter->filter_dx = 0.0;
+	filter->filter_x = x;
+
+	/* Run from rest on the held value until settled. */
+	filter->filter_state[0] = 0.0;
+	filter->filter_state[1] = 0.0;
+	for(int i = 0; filter->filter_type == JOYSTICK_FILTER_BIQUAD && i < 20000; i++){
+		bench_filter_biquad(filter, x);
+	}
+
+	return x;
+}
+
+static double bench_filter_apply(struct bench_filter *filter, double x, uint32_t dt_ms)
+{
+	const double dt = (double)dt_ms/1000.0;
+
+	switch(filter->filter_type)
+	{
+		case JOYSTICK_FILTER_LOW_PASS:
+			filter->filter_y += (x - filter->filter_y)*dt/(dt + filter->filter_tau);
+		return filter->filter_y;
+
+		case JOYSTICK_FILTER_ONE_EURO:
+		{
+			const double dx = (x - filter->filter_y)/dt;
+			filter->filter_dx += (dx - filter->filter_dx)*dt/(dt + filter->filter_tau_derivative);
+
+			const double cutoff = 1.0/(2.0*M_PI*filter->filter_tau) + filter->filter_beta*fabs(filter->filter_dx);
+			const double tau = 1.0/(2.0*M_PI*cutoff);
+			filter->filter_y += (x - filter->filter_y)*dt/(dt + tau);
+		}
+		return filter->filter_y;
+
+		case JOYSTICK_FILTER_BIQUAD:
+			for(uint32_t ms = 1; ms < dt_ms; ms++){
+				bench_filter_biquad(filter, filter->filter_x);
+			}
+			filter->filter_x = x;
+		return bench_filter_biquad(filter, x);
+
+		default:
+		return x;
+	}
+}
+
+/*
+ * Device with JOYSTICK_DEVICE_AXIS_MAX axes. A map of all of them is
+ * refused, decode drops the axes past JOYSTICK_AXIS_MAX and a map over
+ * the upper window of the dynamic value sees them.
+ */
+static void bench_check_wide(void)
+{
+	struct joystick_input_attrib input_attrib;
+	memset(&input_attrib, 0, sizeof input_attrib);
+	input_attrib.joystick_axis_count = JOYSTICK_DEVICE_AXIS_MAX;
+	input_attrib.joystick_button_count = 1;
+
+	struct joystick_device device;
+	joystick_device_create(&device, -1, &input_attrib);
+
+	static uint8_t memory[4096];
+	struct joystick_arena arena;
+	joystick_arena_create(&arena, memory, sizeof memory);
+
+	struct joystick_input_dynamic input_dynamic;
+	struct joystick_map map;
+
+	if(joystick_map_create(&map, JOYSTICK_DEVICE_AXIS_MAX, 2) == 0
+	|| joystick_map_create(&map, JOYSTICK_MAP_INPUT_MAX, 0) == 0
+	|| joystick_input_dynamic_create(&input_dynamic, &input_attrib, &arena) < 0
+	|| joystick_map_create(&map, JOYSTICK_DEVICE_AXIS_MAX - JOYSTICK_MAP_INPUT_MAX, 2) < 0)
+	{
+		fprintf(stderr, "bench_check_wide(): map sizes not checked \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Output 0 is axis 40, output 1 is axis 63. */
+	const uint32_t first = JOYSTICK_DEVICE_AXIS_MAX - JOYSTICK_MAP_INPUT_MAX;
+	const float scale_40[2] = {1.0f, 0.0f};
+	const float scale_63[2] = {0.0f, 1.0f};
+	joystick_map_transform(&map, 40 - first, scale_40, 2);
+	joystick_map_transform(&map, 63 - first, scale_63, 2);
+
+	const struct js_event events[] = {
+		{.time = 1, .value = INT16_MAX/2, .type = JS_EVENT_AXIS, .number = 0},
+		{.time = 2, .value = INT16_MAX, .type = JS_EVENT_AXIS, .number = 40},
+		{.time = 3, .value = -INT16_MAX, .type = JS_EVENT_AXIS, .number = 63},
+	};
+	const size_t event_count = sizeof events/sizeof events[0];
+
+	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+	joystick_device_decode(&device, events, event_count, &input_value);
+	joystick_device_decode_dynamic(&device, events, event_count, &input_dynamic);
+
+	float output[2];
+	joystick_map_translate_array(&map, &input_dynamic.dynamic_axis_value[first], output, 2);
+
+	if(input_value.joystick_axis_changed != 1
+	|| !joystick_input_dynamic_test(input_dynamic.dynamic_axis_changed, 63)
+	|| output[0] != 1.0f || output[1] != -1.0f)
+	{
+		fprintf(stderr, "bench_check_wide(): axes past %d not mapped, output %f %f \n", JOYSTICK_AXIS_MAX, (double)output[0], (double)output[1]);
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_map_destroy(&map);
+}
+
+/*
+ * Filters run by decode against a double precision reference, for event
+ * gaps from 0 ms to beyond the biquad settle limit, across the wrap of the
+ * event time, with INIT events restarting the filter midway.
+ */
+static void bench_check_filter(void)
+{
+	const uint32_t gaps_ms[] = {0, 1, 1, 2, 3, 5, 8, 13, 1, 0, 40, 120, JOYSTICK_FILTER_BIQUAD_STEP_MAX + 1, 400, 1, 2};
+	const size_t gap_count = sizeof gaps_ms/sizeof gaps_ms[0];
+	const size_t event_count = 4*gap_count;
+
+	const enum joystick_filter_type types[] = {JOYSTICK_FILTER_LOW_PASS, JOYSTICK_FILTER_ONE_EURO, JOYSTICK_FILTER_BIQUAD};
+
+	for(size_t t = 0; t < sizeof types/sizeof types[0]; t++)
+	{
+		struct joystick_filter_config config;
+		joystick_filter_config_default(&config, types[t]);
+
+		struct joystick_filter *filter = malloc(sizeof(struct joystick_filter));
+		if(filter == NULL){
+			fprintf(stderr, "malloc(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		joystick_filter_create(filter);
+		joystick_filter_set(filter, 0, &config);
+
+		struct bench_filter reference;
+		memset(&reference, 0, sizeof reference);
+		reference.filter_type = types[t];
+		reference.filter_tau = 1.0/(2.0*M_PI*config.config_cutoff);
+		reference.filter_beta = config.config_beta;
+		reference.filter_tau_derivative = 1.0/(2.0*M_PI*config.config_derivative_cutoff);
+
+		const double w0 = 2.0*M_PI*config.config_cutoff/JOYSTICK_FILTER_BIQUAD_RATE;
+		const double alpha = sin(w0)/(2.0*config.config_q);
+		const double a0 = 1.0 + alpha;
+		reference.filter_b[0] = (1.0 - cos(w0))/2.0/a0;
+		reference.filter_b[1] = (1.0 - cos(w0))/a0;
+		reference.filter_b[2] = reference.filter_b[0];
+		reference.filter_a[1] = -2.0*cos(w0)/a0;
+		reference.filter_a[2] = (1.0 - alpha)/a0;
+
+		struct joystick_input_attrib input_attrib;
+		memset(&input_attrib, 0, sizeof input_attrib);
+		input_attrib.joystick_axis_count = 1;
+
+		struct joystick_device device;
+		joystick_device_create(&device, -1, &input_attrib);
+		joystick_device_use_filter(&device, filter);
+
+		struct joystick_input_value input_value;
+		memset(&input_value, 0, sizeof input_value);
+
+		/* Starts close to the wrap of the 32 bit millisecond time. */
+		uint32_t time = UINT32_MAX - 1000;
+		double error = 0.0;
+
+		for(size_t e = 0; e <= event_count; e++)
+		{
+			struct js_event event;
+			event.time = time;
+			event.value = (int16_t)(bench_random()*(float)INT16_MAX);
+			event.type = JS_EVENT_AXIS;
+			event.number = 0;
+
+			const double x = (double)event.value/INT16_MAX;
+			double expected;
+
+			if(e == 0 || e == event_count/2)
+			{
+				event.type |= JS_EVENT_INIT;
+				expected = bench_filter_start(&reference, x);
+			}
+			else
+			{
+				const uint32_t gap_ms = gaps_ms[e%gap_count];
+				expected = bench_filter_apply(&reference, x, gap_ms == 0 ? 1 : gap_ms);
+			}
+
+			joystick_device_decode(&device, &event, 1, &input_value);
+
+			const double difference = fabs((double)input_value.joystick_axis_value[0] - expected);
+			error = difference > error ? difference : error;
+
+			time = time + gaps_ms[(e + 1)%gap_count];
+		}
+
+		free(filter);
+
+		if(error > BENCH_FILTER_ERROR){
+			fprintf(stderr, "filter type %d: error %g \n", (int)types[t], error);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/*
+ * Fixed point outputs of full maps with full scale inputs saturate at
+ * [-INT16_MAX, INT16_MAX], and integer decode reports the button edges
+ * the float decode does.
+ */
+static void bench_check_q15(void)
+{
+	const float elements[] = {1.0f, 126.0f};
+	const int16_t inputs[] = {INT16_MAX, -INT16_MAX, INT16_MIN};
+
+	static struct joystick_map map;
+	static struct joystick_map_q15 map_q15;
+
+	for(size_t e = 0; e < sizeof elements/sizeof elements[0]; e++)
+	{
+		joystick_map_create(&map, JOYSTICK_MAP_INPUT_MAX, JOYSTICK_MAP_OUTPUT_MAX);
+
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < JOYSTICK_MAP_OUTPUT_MAX; i++){
+			output_scale[i] = elements[e];
+		}
+
+		for(uint32_t j = 0; j < JOYSTICK_MAP_INPUT_MAX; j++){
+			joystick_map_transform(&map, j, output_scale, JOYSTICK_MAP_OUTPUT_MAX);
+		}
+
+		if(joystick_map_q15_create(&map, &map_q15) < 0){
+			fprintf(stderr, "joystick_map_q15_create(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		for(size_t k = 0; k < sizeof inputs/sizeof inputs[0]; k++)
+		{
+			struct joystick_input_value_q15 input_value;
+			memset(&input_value, 0, sizeof input_value);
+			for(uint32_t j = 0; j < JOYSTICK_MAP_INPUT_MAX; j++){
+				input_value.joystick_axis_value[j] = inputs[k];
+			}
+
+			int16_t output[JOYSTICK_MAP_OUTPUT_MAX];
+			joystick_map_q15_translate(&map_q15, &input_value, output, JOYSTICK_MAP_OUTPUT_MAX);
+
+			const int16_t expected = inputs[k] > 0 ? INT16_MAX : -INT16_MAX;
+			for(uint32_t i = 0; i < JOYSTICK_MAP_OUTPUT_MAX; i++)
+			{
+				if(output[i] != expected){
+					fprintf(stderr, "bench_check_q15(): elements %f inputs %d gave %d, expected %d \n", (double)elements[e], inputs[k], output[i], expected);
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+
+		joystick_map_destroy(&map);
+	}
+
+	struct joystick_input_attrib input_attrib;
+	memset(&input_attrib, 0, sizeof input_attrib);
+	input_attrib.joystick_axis_count = 1;
+	input_attrib.joystick_button_count = 3;
+
+	struct joystick_device device;
+	joystick_device_create(&device, -1, &input_attrib);
+
+	/* Held at start, tapped within the batch, pressed. */
+	const struct js_event events[] = {
+		{.time = 1, .value = 1, .type = JS_EVENT_BUTTON | JS_EVENT_INIT, .number = 0},
+		{.time = 2, .value = 1, .type = JS_EVENT_BUTTON, .number = 1},
+		{.time = 3, .value = 0, .type = JS_EVENT_BUTTON, .number = 1},
+		{.time = 4, .value = 1, .type = JS_EVENT_BUTTON, .number = 2},
+		{.time = 5, .value = 0, .type = JS_EVENT_BUTTON, .number = 0},
+	};
+	const size_t event_count = sizeof events/sizeof events[0];
+
+	struct joystick_input_value input_value;
+	struct joystick_input_value_q15 input_value_q15;
+	memset(&input_value, 0, sizeof input_value);
+	memset(&input_value_q15, 0, sizeof input_value_q15);
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		joystick_device_decode(&device, &events[i], 1, &input_value);
+		joystick_device_decode_q15(&device, &events[i], 1, &input_value_q15);
+
+		if(input_value_q15.joystick_button_pressed != input_value.joystick_button_pressed
+		|| input_value_q15.joystick_button_released != input_value.joystick_button_released
+		|| input_value_q15.joystick_button_changed != input_value.joystick_button_changed)
+		{
+			fprintf(stderr, "bench_check_q15(): button edges differ after event %zu \n", i);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	joystick_input_value_q15_clear_changed(&input_value_q15);
+
+	if(input_value.joystick_button_pressed != 0x6 || input_value.joystick_button_released != 0x3
+	|| input_value.joystick_button_changed != 0x7 || input_value_q15.joystick_button_changed != 0)
+	{
+		fprintf(stderr, "bench_check_q15(): button edges not reported \n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Conversions of compact state to and from float and integer values.
+ * Axes round and clamp, unused axes and buttons stay zero both ways, and
+ * compare ignores the sequence and time.
+ */
+static void bench_check_state(void)
+{
+	struct joystick_input_attrib input_attrib;
+	memset(&input_attrib, 0, sizeof input_attrib);
+	input_attrib.joystick_axis_count = 6;
+	input_attrib.joystick_button_count = 6;
+
+	const float axes[6] = {0.25f, -0.25f, 1.0f, -1.0f, 2.0f, -2.0f};
+	const int16_t expected_axes[6] = {8192, -8192, INT16_MAX, -INT16_MAX, INT16_MAX, INT16_MIN};
+	const int16_t buttons[6] = {1, 0, 5, 0, -1, 0};
+
+	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+
+	/* Axes and buttons past the counts are not used. */
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+		input_value.joystick_axis_value[i] = i < 6 ? axes[i] : 0.75f;
+	}
+
+	for(uint32_t i = 0; i < JOYSTICK_BUTTON_MAX; i++){
+		input_value.joystick_button_value[i] = i < 6 ? buttons[i] : 1;
+	}
+
+	input_value.joystick_event_time = 1234;
+
+	struct joystick_state state;
+	joystick_state_create(&state, &input_attrib);
+	joystick_state_from_value(&state, &input_value);
+
+	int error = state.state_sequence != 1 || state.state_event_time != 1234 || state.state_button != 0x15;
+
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+		error |= state.state_axis[i] != (i < 6 ? expected_axes[i] : 0);
+	}
+
+	if(error){
+		fprintf(stderr, "bench_check_state(): from value mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Back to float, full scale is exactly 1.0 and INT16_MIN a little below -1.0. */
+	joystick_state_to_value(&state, &input_value);
+
+	error = input_value.joystick_event_time != 1234
+		|| input_value.joystick_axis_value[2] != 1.0f
+		|| input_value.joystick_axis_value[3] != -1.0f
+		|| input_value.joystick_axis_value[5] >= -1.0f
+		|| input_value.joystick_axis_changed != 0
+		|| input_value.joystick_button_changed != 0;
+
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+		error |= input_value.joystick_axis_value[i] != (float)state.state_axis[i]/(float)INT16_MAX;
+	}
+
+	for(uint32_t i = 0; i < JOYSTICK_BUTTON_MAX; i++){
+		error |= input_value.joystick_button_value[i] != (int16_t)((0x15u >> i) & 1u);
+	}
+
+	struct joystick_state round_trip;
+	joystick_state_create(&round_trip, &input_attrib);
+	joystick_state_from_value(&round_trip, &input_value);
+
+	error |= joystick_state_is_equal(&state, &round_trip) != 1
+		|| memcmp(state.state_axis, round_trip.state_axis, sizeof state.state_axis) != 0;
+
+	if(error){
+		fprintf(stderr, "bench_check_state(): float round trip mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value_q15 input_value_q15;
+	joystick_state_to_value_q15(&state, &input_value_q15);
+
+	error = input_value_q15.joystick_event_time != 1234;
+
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+		error |= input_value_q15.joystick_axis_value[i] != state.state_axis[i];
+		input_value_q15.joystick_axis_value[i] = i < 6 ? input_value_q15.joystick_axis_value[i] : 100;
+	}
+
+	for(uint32_t i = 0; i < JOYSTICK_BUTTON_MAX; i++){
+		error |= input_value_q15.joystick_button_value[i] != (int16_t)((0x15u >> i) & 1u);
+		input_value_q15.joystick_button_value[i] = i < 6 ? input_value_q15.joystick_button_value[i] : 1;
+	}
+
+	joystick_state_create(&round_trip, &input_attrib);
+	joystick_state_from_value_q15(&round_trip, &input_value_q15);
+
+	error |= round_trip.state_sequence != 1
+		|| round_trip.state_button != 0x15
+		|| joystick_state_is_equal(&state, &round_trip) != 1
+		|| memcmp(state.state_axis, round_trip.state_axis, sizeof state.state_axis) != 0;
+
+	if(error){
+		fprintf(stderr, "bench_check_state(): integer round trip mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Sequence and time are ignored, axes and buttons are not. */
+	round_trip.state_sequence = 7;
+	round_trip.state_event_time = 99;
+
+	error = joystick_state_is_equal(&state, &round_trip) != 1 || joystick_state_axis_changed(&state, &round_trip) != 0;
+
+	round_trip.state_button ^= 1u << 3;
+	error |= joystick_state_is_equal(&state, &round_trip) != -1 || joystick_state_axis_changed(&state, &round_trip) != 0;
+
+	round_trip.state_button = state.state_button;
+	round_trip.state_axis[0] = 0;
+	round_trip.state_axis[5] = INT16_MAX;
+	error |= joystick_state_is_equal(&state, &round_trip) != -1 || joystick_state_axis_changed(&state, &round_trip) != ((1u << 0) | (1u << 5));
+
+	if(error){
+		fprintf(stderr, "bench_check_state(): compare mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Fixed point map against the float map, outputs must be within 1 LSB.
+ */
+static void bench_translate_q15(uint32_t input_count, uint32_t output_count)
+{
+	static struct joystick_map map;
+	joystick_map_create(&map, input_count, output_count);
+
+	for(uint32_t j = 0; j < input_count; j++)
+	{
+		float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+		for(uint32_t i = 0; i < output_count; i++){
+			output_scale[i] = bench_random()*2.0f/(float)input_count;
+		}
+
+		joystick_map_transform(&map, j, output_scale, output_count);
+	}
+
+	for(uint32_t i = 0; i < output_count; i++){
+		map.map_offset[i] = bench_random()*0.5f;
+	}
+
+	static struct joystick_map_q15 map_q15;
+	if(joystick_map_q15_create(&map, &map_q15) < 0){
+		fprintf(stderr, "joystick_map_q15_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value *input_values = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value));
+	struct joystick_input_value_q15 *input_values_q15 = calloc(BENCH_FRAMES, sizeof(struct joystick_input_value_q15));
+	if(input_values == NULL || input_values_q15 == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			const int16_t raw = (int16_t)(rand() % 65536 + INT16_MIN);
+			input_values_q15[f].joystick_axis_value[j] = raw;
+			input_values[f].joystick_axis_value[j] = (float)raw/(float)INT16_MAX;
+		}
+	}
+
+	float output[JOYSTICK_MAP_OUTPUT_MAX];
+	int16_t output_q15[JOYSTICK_MAP_OUTPUT_MAX];
+
+	for(size_t f = 0; f < BENCH_FRAMES; f++)
+	{
+		joystick_map_translate(&map, &input_values[f], output, output_count);
+		joystick_map_q15_translate(&map_q15, &input_values_q15[f], output_q15, output_count);
+
+		for(uint32_t i = 0; i < output_count; i++)
+		{
+			float expected = output[i]*(float)INT16_MAX;
+			expected = expected > (float)INT16_MAX ? (float)INT16_MAX : expected < -(float)INT16_MAX ? -(float)INT16_MAX : expected;
+
+			const long difference = lroundf(expected) - output_q15[i];
+			if(difference > 1 || difference < -1){
+				fprintf(stderr, "joystick_map_q15_translate(): off by %ld \n", difference);
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	volatile float sink = 0.0f;
+	double best[2] = {1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_translate(&map, &input_values[f], output, output_count);
+			sink = sink + output[0];
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		for(size_t f = 0; f < BENCH_FRAMES; f++){
+			joystick_map_q15_translate(&map_q15, &input_values_q15[f], output_q15, output_count);
+			sink = sink + output_q15[0];
+		}
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+	}
+
+	bench_report("translate_q15_baseline", input_count, output_count, best[0]);
+	bench_report("translate_q15", input_count, output_count, best[1]);
+
+	free(input_values_q15);
+	free(input_values);
+
+	joystick_map_destroy(&map);
+}
+
+/*
+ * joystick_map_translate over a range of map sizes.
+ */
+static void bench_translate_sweep(void)
+{
+	const uint32_t counts[] = {2, 6, 16, 32};
+	const size_t count_length = sizeof counts/sizeof counts[0];
+
+	struct joystick_input_value *input_values = calloc(BENCH_SWEEP_FRAMES, sizeof(struct joystick_input_value));
+	if(input_values == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t f = 0; f < BENCH_SWEEP_FRAMES; f++)
+	{
+		for(uint32_t j = 0; j < JOYSTICK_AXIS_MAX; j++){
+			input_values[f].joystick_axis_value[j] = bench_random();
+		}
+	}
+
+	static struct joystick_map map;
+	float output[JOYSTICK_MAP_OUTPUT_MAX];
+
+	for(size_t a = 0; a < count_length; a++)
+	{
+		for(size_t b = 0; b < count_length; b++)
+		{
+			const uint32_t input_count = counts[a];
+			const uint32_t output_count = counts[b];
+
+			joystick_map_create(&map, input_count, output_count);
+
+			for(uint32_t j = 0; j < input_count; j++)
+			{
+				float output_scale[JOYSTICK_MAP_OUTPUT_MAX];
+				for(uint32_t i = 0; i < output_count; i++){
+					output_scale[i] = bench_random();
+				}
+
+				joystick_map_transform(&map, j, output_scale, output_count);
+			}
+
+			double best = 1e9;
+			for(int r = 0; r < BENCH_REPEAT; r++)
+			{
+				double t = bench_now();
+				for(size_t f = 0; f < BENCH_SWEEP_FRAMES; f++){
+					joystick_map_translate(&map, &input_values[f], output, output_count);
+				}
+				t = bench_now() - t;
+				best = t < best ? t : best;
+			}
+
+			char params[64];
+			snprintf(params, sizeof params, "inputs=%u outputs=%u frames=%d", (unsigned)input_count, (unsigned)output_count, BENCH_SWEEP_FRAMES);
+			bench_emit("translate_sweep", params, "fps", (double)BENCH_SWEEP_FRAMES/best);
+
+			joystick_map_destroy(&map);
+		}
+	}
+
+	free(input_values);
+}
+
+/*
+ * Read a device until it ends.
+ *
+ * @return Returns number of events read.
+ */
+static size_t bench_read_all(struct joystick_device *device, struct js_event *events, size_t event_max)
+{
+	size_t event_count = 0;
+
+	for(;;)
+	{
+		struct pollfd poll_fd = {.fd = device->device_fd, .events = POLLIN};
+		if(poll(&poll_fd, 1, 1000) <= 0){
+			fprintf(stderr, "poll(): timeout \n");
+			exit(EXIT_FAILURE);
+		}
+
+		int result = joystick_device_read(device, &events[event_count], event_max - event_count);
+		if(result < 0){
+			return event_count;
+		}
+
+		event_count = event_count + (size_t)result;
+		if(event_count == event_max){
+			fprintf(stderr, "joystick_device_read(): too many events \n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+/*
+ * Record events written to a stream device and replay the recording. The
+ * replayed device reports the recorded attributes and reads the same
+ * events. Files with another magic or version are refused.
+ */
+static void bench_check_record(void)
+{
+	char path[] = "/tmp/joystick_bench_XXXXXX";
+	int fd = mkstemp(path);
+	if(fd < 0){
+		fprintf(stderr, "mkstemp(): error \n");
+		exit(EXIT_FAILURE);
+	}
+	close(fd);
+
+	struct joystick_source_config config;
+	joystick_source_config_default(&config, JOYSTICK_SOURCE_STREAM);
+	strcpy((char *)config.config_input_attrib.joystick_name, "Recorded joystick");
+	config.config_input_attrib.joystick_axis_count = 4;
+	config.config_input_attrib.joystick_button_count = 3;
+
+	enum { event_count = 500 };
+	struct js_event written[event_count];
+	struct js_event read[2][event_count + 1];
+
+	for(size_t e = 0; e < event_count; e++)
+	{
+		const int axis = e%3 != 0;
+		written[e].time = (uint32_t)(e/4);
+		written[e].value = axis ? (int16_t)(bench_random()*(float)INT16_MAX) : (int16_t)(e/3%2);
+		written[e].type = axis ? JS_EVENT_AXIS : JS_EVENT_BUTTON;
+		written[e].number = (uint8_t)(axis ? e%4 : e%3);
+	}
+
+	struct joystick_source source;
+	struct joystick_device device;
+	struct joystick_record record;
+
+	if(joystick_source_open(&source, &device, &config) < 0 || joystick_record_create(&record, path, &device.input_attrib) < 0){
+		fprintf(stderr, "joystick_record_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_device_use_record(&device, &record);
+
+	if(joystick_source_write(&source, written, event_count) < 0){
+		fprintf(stderr, "joystick_source_write(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_source_close(&source);
+	const size_t recorded_count = bench_read_all(&device, read[0], event_count + 1);
+
+	int error = joystick_record_close(&record) < 0;
+
+	config.config_type = JOYSTICK_SOURCE_REPLAY;
+	config.config_device_path = path;
+	config.config_realtime = 0;
+
+	struct joystick_device replayed;
+	if(joystick_source_open(&source, &replayed, &config) < 0){
+		fprintf(stderr, "joystick_source_open(): replay error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	error |= strcmp((const char *)replayed.input_attrib.joystick_name, "Recorded joystick") != 0;
+	error |= strcmp((const char *)replayed.input_attrib.joystick_device_path, path) != 0;
+	error |= replayed.input_attrib.joystick_axis_count != 4 || replayed.input_attrib.joystick_button_count != 3;
+
+	const size_t replayed_count = bench_read_all(&replayed, read[1], event_count + 1);
+	joystick_source_close(&source);
+
+	error |= recorded_count != event_count || replayed_count != event_count;
+	error |= memcmp(read[0], written, sizeof written) != 0 || memcmp(read[1], written, sizeof written) != 0;
+
+	struct joystick_input_value input_value[2];
+	memset(input_value, 0, sizeof input_value);
+	joystick_device_decode(&device, written, event_count, &input_value[0]);
+	joystick_device_decode(&replayed, read[1], replayed_count, &input_value[1]);
+	error |= memcmp(&input_value[0], &input_value[1], sizeof input_value[0]) != 0;
+
+	/* A header with another magic, then another version. */
+	for(int field = 0; field < 2; field++)
+	{
+		struct joystick_record_header header;
+		memset(&header, 0, sizeof header);
+		header.header_magic = field == 0 ? JOYSTICK_RECORD_MAGIC + 1 : JOYSTICK_RECORD_MAGIC;
+		header.header_version = field == 1 ? JOYSTICK_RECORD_VERSION + 1 : JOYSTICK_RECORD_VERSION;
+
+		FILE *file = fopen(path, "wb");
+		if(file == NULL || fwrite(&header, sizeof header, 1, file) != 1 || fclose(file) != 0){
+			fprintf(stderr, "fwrite(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		if(joystick_source_open(&source, &replayed, &config) == 0){
+			joystick_source_close(&source);
+			joystick_device_close(&replayed);
+			error = 1;
+		}
+	}
+
+	unlink(path);
+
+	if(error){
+		fprintf(stderr, "record: mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+#define BENCH_OPENER_MAX 16
+
+/*
+ * Opens a stream source for every jsN node that exists, so hotplug and
+ * reconnect are checked without joydev nodes.
+ */
+struct bench_opener
+{
+	size_t opener_count;
+	struct joystick_source opener_source[BENCH_OPENER_MAX];
+};
+
+static int bench_opener_open(const char *device_path, struct joystick_input_attrib *input_attrib, void *opener_arg)
+{
+	struct bench_opener *bench_opener = opener_arg;
+
+	struct stat node;
+	if(stat(device_path, &node) < 0 || bench_opener->opener_count == BENCH_OPENER_MAX){
+		return -1;
+	}
+
+	struct joystick_source_config config;
+	joystick_source_config_default(&config, JOYSTICK_SOURCE_STREAM);
+	strcpy((char *)config.config_input_attrib.joystick_name, "Hotplug joystick");
+	snprintf((char *)config.config_input_attrib.joystick_device_path, sizeof config.config_input_attrib.joystick_device_path, "%s", device_path);
+	config.config_input_attrib.joystick_axis_count = 2;
+	config.config_input_attrib.joystick_button_count = 2;
+
+	struct joystick_device device;
+	if(joystick_source_open(&bench_opener->opener_source[bench_opener->opener_count], &device, &config) < 0){
+		return -1;
+	}
+
+	bench_opener->opener_count = bench_opener->opener_count + 1;
+	memcpy(input_attrib, &device.input_attrib, sizeof(struct joystick_input_attrib));
+
+	return device.device_fd;
+}
+
+static int bench_hotplug_node(const char *path)
+{
+	const int fd = open(path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+	if(fd < 0){
+		return -1;
+	}
+
+	return close(fd);
+}
+
+/*
+ * Process hotplug events and require one event of the given type at path.
+ */
+static void bench_hotplug_expect(struct joystick_hotplug *hotplug, struct joystick_hotplug_event *event, enum joystick_hotplug_type type, const char *path)
+{
+	struct joystick_hotplug_event events[4];
+	const int event_count = joystick_hotplug_process(hotplug, events, 4);
+
+	if(event_count != 1 || events[0].hotplug_type != type
+	|| strcmp((const char *)events[0].hotplug_input_attrib.joystick_device_path, path) != 0
+	|| strcmp((const char *)events[0].hotplug_input_attrib.joystick_name, "Hotplug joystick") != 0)
+	{
+		fprintf(stderr, "bench_hotplug_expect(): %d events, expected %s of %s \n", event_count, type == JOYSTICK_HOTPLUG_ADD ? "add" : "remove", path);
+		exit(EXIT_FAILURE);
+	}
+
+	*event = events[0];
+}
+
+/*
+ * A jsN node created and removed in a temporary directory is reported as
+ * added and removed, only other names are ignored, and a device set closes
+ * the stream device on the remove and reopens it on the add. Removing the
+ * directory makes process fail.
+ */
+static void bench_check_hotplug(void)
+{
+	char root[] = "/tmp/joystick_hotplug_XXXXXX";
+	char path[sizeof root + 8];
+	char other[sizeof root + 8];
+
+	static struct bench_opener bench_opener;
+	static struct joystick_hotplug hotplug;
+	static struct joystick_device_set set;
+
+	const struct joystick_device_opener opener = {bench_opener_open, &bench_opener};
+
+	if(mkdtemp(root) == NULL
+	|| joystick_hotplug_create_with(&hotplug, root, &opener) < 0
+	|| joystick_device_set_create(&set) < 0)
+	{
+		fprintf(stderr, "bench_check_hotplug(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	snprintf(path, sizeof path, "%s/js0", root);
+	snprintf(other, sizeof other, "%s/event0", root);
+
+	struct joystick_hotplug_event event;
+	struct joystick_hotplug_event events[4];
+	struct joystick_device_update updates[4];
+
+	if(bench_hotplug_node(other) < 0 || joystick_hotplug_process(&hotplug, events, 4) != 0){
+		fprintf(stderr, "bench_check_hotplug(): %s reported \n", other);
+		exit(EXIT_FAILURE);
+	}
+
+	bench_hotplug_node(path);
+	bench_hotplug_expect(&hotplug, &event, JOYSTICK_HOTPLUG_ADD, path);
+
+	const int index = joystick_device_set_open_with(&set, path, &opener);
+	struct joystick_device *device = index >= 0 ? joystick_device_set_device(&set, (size_t)index) : NULL;
+
+	const struct js_event js_event = {.time = 1, .value = INT16_MAX, .type = JS_EVENT_AXIS, .number = 1};
+
+	if(device == NULL
+	|| joystick_source_write(&bench_opener.opener_source[bench_opener.opener_count - 1], &js_event, 1) < 0
+	|| joystick_device_set_poll(&set, updates, 4, 1000) != 1)
+	{
+		fprintf(stderr, "bench_check_hotplug(): stream device not read \n");
+		exit(EXIT_FAILURE);
+	}
+
+	unlink(path);
+	bench_hotplug_expect(&hotplug, &event, JOYSTICK_HOTPLUG_REMOVE, path);
+
+	if(joystick_device_set_hotplug(&set, &event, 1) != 0 || joystick_device_is_open(device) > 0){
+		fprintf(stderr, "bench_check_hotplug(): device open after remove \n");
+		exit(EXIT_FAILURE);
+	}
+
+	bench_hotplug_node(path);
+	bench_hotplug_expect(&hotplug, &event, JOYSTICK_HOTPLUG_ADD, path);
+
+	const struct js_event js_event_reconnect = {.time = 2, .value = -INT16_MAX, .type = JS_EVENT_AXIS, .number = 1};
+
+	if(joystick_device_set_hotplug(&set, &event, 1) != 1
+	|| joystick_source_write(&bench_opener.opener_source[bench_opener.opener_count - 1], &js_event_reconnect, 1) < 0
+	|| joystick_device_set_poll(&set, updates, 4, 1000) != 1
+	|| joystick_device_set_value(&set, (size_t)index)->joystick_axis_value[1] != -1.0f)
+	{
+		fprintf(stderr, "bench_check_hotplug(): device not reconnected \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Two removes watched by the set, reported one per poll with room for one. */
+	char paths[2][sizeof root + 8];
+	int indices[2];
+
+	for(size_t k = 0; k < 2; k++)
+	{
+		snprintf(paths[k], sizeof paths[k], "%s/js%zu", root, k + 1);
+		bench_hotplug_node(paths[k]);
+	}
+
+	joystick_hotplug_process(&hotplug, events, 4);
+
+	for(size_t k = 0; k < 2; k++){
+		indices[k] = joystick_device_set_open_with(&set, paths[k], &opener);
+	}
+
+	if(indices[0] < 0 || indices[1] < 0 || joystick_device_set_watch(&set, &hotplug) < 0){
+		fprintf(stderr, "bench_check_hotplug(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	unlink(paths[0]);
+	unlink(paths[1]);
+
+	for(size_t k = 0; k < 2; k++)
+	{
+		if(joystick_device_set_poll(&set, updates, 1, 1000) != 1
+		|| updates[0].update_index != (size_t)indices[k]
+		|| updates[0].update_result != -1)
+		{
+			fprintf(stderr, "bench_check_hotplug(): remove %zu not reported by its own poll \n", k + 1);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if(joystick_device_set_poll(&set, updates, 1, 0) != 0){
+		fprintf(stderr, "bench_check_hotplug(): removes reported twice \n");
+		exit(EXIT_FAILURE);
+	}
+
+	unlink(path);
+	unlink(other);
+	rmdir(root);
+
+	if(joystick_hotplug_process(&hotplug, events, 4) >= 0){
+		fprintf(stderr, "bench_check_hotplug(): removed directory not reported \n");
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_device_set_destroy(&set);
+	joystick_hotplug_destroy(&hotplug);
+
+	for(size_t i = 0; i < bench_opener.opener_count; i++){
+		joystick_source_close(&bench_opener.opener_source[i]);
+	}
+}
+
+/*
+ * Publish through one mapping of a region and read through another, for a
+ * named and an anonymous region. A second owner of a taken name must fail.
+ */
+static void bench_check_shm(void)
+{
+	struct joystick_input_attrib input_attrib;
+	memset(&input_attrib, 0, sizeof input_attrib);
+	strcpy((char *)input_attrib.joystick_name, "bench");
+	input_attrib.joystick_axis_count = 6;
+	input_attrib.joystick_button_count = 12;
+
+	char name[NAME_MAX + 1];
+	snprintf(name, sizeof name, "/joystick_bench_%ld", (long)getpid());
+
+	for(int named = 0; named < 2; named++)
+	{
+		struct joystick_shm owner;
+		struct joystick_shm reader;
+
+		if(joystick_shm_create(&owner, named ? name : NULL, &input_attrib) < 0){
+			fprintf(stderr, "joystick_shm_create(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		int error = 0;
+
+		if(named)
+		{
+			struct joystick_shm other;
+			if(joystick_shm_create(&other, name, &input_attrib) == 0 || other.shm_fd != -1){
+				error = 1;
+			}
+
+			if(joystick_shm_attach(&reader, name) < 0){
+				fprintf(stderr, "joystick_shm_attach(): error \n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(joystick_shm_attach_fd(&reader, owner.shm_fd) < 0){
+			fprintf(stderr, "joystick_shm_attach_fd(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		error |= (void *)reader.shm_region == (void *)owner.shm_region;
+		error |= memcmp(joystick_shm_input_attrib(&reader), &input_attrib, sizeof input_attrib) != 0;
+
+		struct joystick_input_value written;
+		struct joystick_input_value read;
+
+		for(uint32_t w = 1; w <= 100; w++)
+		{
+			memset(&written, 0, sizeof written);
+			for(uint32_t a = 0; a < JOYSTICK_AXIS_MAX; a++){
+				written.joystick_axis_value[a] = bench_random();
+			}
+			written.joystick_event_time = w;
+
+			joystick_shm_write(&owner, &written);
+
+			error |= joystick_shm_read(&reader, &read) != w;
+			error |= memcmp(&read, &written, sizeof read) != 0;
+		}
+
+		joystick_shm_destroy(&reader);
+		joystick_shm_destroy(&owner);
+
+		if(named && joystick_shm_attach(&reader, name) == 0){
+			error = 1;
+			joystick_shm_destroy(&reader);
+		}
+
+		if(error){
+			fprintf(stderr, "shm %s: mismatch \n", named ? "named" : "anonymous");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+static void bench_evdev_write(int fd, uint16_t type, uint16_t code, int32_t value)
+{
+	struct input_event event;
+	memset(&event, 0, sizeof event);
+	event.type = type;
+	event.code = code;
+	event.value = value;
+
+	if(write(fd, &event, sizeof event) != (ssize_t)sizeof event){
+		fprintf(stderr, "write(): error \n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Feed an evdev device input_event records through a pipe. A frame is
+ * only visible at SYN_REPORT, values within flat read 0, the ends of the
+ * range read -1 and 1, and a frame with SYN_DROPPED is discarded.
+ */
+static void bench_check_evdev(void)
+{
+	int pipe_fd[2];
+	if(pipe(pipe_fd) < 0){
+		fprintf(stderr, "pipe(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+
+	struct joystick_evdev evdev;
+	joystick_evdev_create(&evdev, pipe_fd[0]);
+
+	/* Center 127.5, flat 15. */
+	struct input_absinfo absinfo;
+	memset(&absinfo, 0, sizeof absinfo);
+	absinfo.minimum = 0;
+	absinfo.maximum = 255;
+	absinfo.flat = 15;
+	absinfo.value = 128;
+
+	if(joystick_evdev_add_axis(&evdev, ABS_X, &absinfo) != 0
+	|| joystick_evdev_add_axis(&evdev, ABS_Y, &absinfo) != 1
+	|| joystick_evdev_add_button(&evdev, BTN_SOUTH) != 0)
+	{
+		fprintf(stderr, "joystick_evdev_add_axis(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+
+	int error = 0;
+
+	/* A two axis move, visible only once the frame is complete. */
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_X, 255);
+	error |= joystick_evdev_poll(&evdev, &input_value) != 0;
+	error |= input_value.joystick_axis_value[0] != 0.0f;
+
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_Y, 0);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	error |= joystick_evdev_poll(&evdev, &input_value) != 1;
+	error |= input_value.joystick_axis_value[0] != 1.0f || input_value.joystick_axis_value[1] != -1.0f;
+	error |= (input_value.joystick_axis_changed & 3) != 3;
+
+	/* Within flat of the center on both sides. */
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_X, 142);
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_Y, 113);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	error |= joystick_evdev_poll(&evdev, &input_value) != 1;
+	error |= input_value.joystick_axis_value[0] != 0.0f || input_value.joystick_axis_value[1] != 0.0f;
+
+	/* Past flat the range left is scaled to [0, 1]. */
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_X, 200);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	error |= joystick_evdev_poll(&evdev, &input_value) != 1;
+	error |= fabsf(input_value.joystick_axis_value[0] - (200.0f - 127.5f - 15.0f)/(127.5f - 15.0f)) > 1e-6f;
+
+	const struct joystick_input_value before = input_value;
+
+	/* Both the event before and after the loss are dropped. */
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_X, 0);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_DROPPED, 0);
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_Y, 255);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	joystick_evdev_poll(&evdev, &input_value);
+	error |= input_value.joystick_axis_value[0] != before.joystick_axis_value[0];
+	error |= input_value.joystick_axis_value[1] != before.joystick_axis_value[1];
+	error |= input_value.joystick_axis_changed != 0;
+
+	/* Changes of two frames read by one poll are merged. */
+	bench_evdev_write(pipe_fd[1], EV_ABS, ABS_Y, 255);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	bench_evdev_write(pipe_fd[1], EV_KEY, BTN_SOUTH, 1);
+	bench_evdev_write(pipe_fd[1], EV_SYN, SYN_REPORT, 0);
+	error |= joystick_evdev_poll(&evdev, &input_value) != 1;
+	error |= input_value.joystick_axis_value[1] != 1.0f || input_value.joystick_button_value[0] != 1;
+	error |= input_value.joystick_axis_changed != 2 || input_value.joystick_button_pressed != 1;
+
+	joystick_evdev_close(&evdev);
+	close(pipe_fd[1]);
+
+	if(error){
+		fprintf(stderr, "evdev: mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Ring and reader thread. Events written to a stream source come out of
+ * the reader in order, through many wraps of the ring array and a wrap of
+ * the free running indices. A ring filled without draining keeps the
+ * oldest events and counts the rest as dropped.
+ */
+static void bench_check_reader(void)
+{
+	enum { chunk = 1000, chunk_count = 200, extra = 77 };
+
+	static struct joystick_ring ring;
+	joystick_ring_create(&ring);
+
+	/* Indices close to UINT32_MAX wrap during the first pushes. */
+	ring.ring_head = ring.ring_tail = ring.ring_head_cache = ring.ring_tail_cache = UINT32_MAX - 100;
+
+	struct js_event events[JOYSTICK_RING_SIZE + extra];
+	uint32_t pushed = 0;
+	uint32_t popped = 0;
+
+	for(size_t r = 0; r < 4*JOYSTICK_RING_SIZE/7; r++)
+	{
+		for(size_t i = 0; i < 7; i++){
+			events[i].time = pushed + (uint32_t)i;
+		}
+		pushed = pushed + (uint32_t)joystick_ring_push(&ring, events, 7);
+
+		const size_t pop_count = joystick_ring_pop(&ring, events, r%2 == 0 ? 5 : 9);
+		for(size_t i = 0; i < pop_count; i++, popped++)
+		{
+			if(events[i].time != popped){
+				fprintf(stderr, "bench_check_reader(): ring popped %u, expected %u \n", events[i].time, popped);
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < JOYSTICK_RING_SIZE + extra; i++){
+		events[i].time = (uint32_t)i;
+	}
+
+	const size_t full_count = JOYSTICK_RING_SIZE - (pushed - popped);
+
+	if(joystick_ring_push(&ring, events, full_count + extra) != full_count
+	|| joystick_ring_dropped(&ring) != extra
+	|| joystick_ring_push(&ring, events, 1) != 0)
+	{
+		fprintf(stderr, "bench_check_reader(): full ring not detected \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_source_config config;
+	joystick_source_config_default(&config, JOYSTICK_SOURCE_STREAM);
+	config.config_input_attrib.joystick_axis_count = 4;
+
+	static struct joystick_source source;
+	static struct joystick_device device;
+	static struct joystick_reader reader;
+
+	if(joystick_source_open(&source, &device, &config) < 0 || joystick_reader_start(&reader, &device) < 0){
+		fprintf(stderr, "bench_check_reader(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	uint32_t written = 0;
+	uint32_t drained = 0;
+
+	for(size_t c = 0; c <= chunk_count; c++)
+	{
+		/* The last chunk fills the ring without draining. */
+		const size_t event_count = c < chunk_count ? chunk : JOYSTICK_RING_SIZE + extra;
+
+		for(size_t i = 0; i < event_count; i++)
+		{
+			events[i].time = written + (uint32_t)i;
+			events[i].value = (int16_t)(written + i);
+			events[i].type = JS_EVENT_AXIS;
+			events[i].number = (uint8_t)((written + i)%4);
+		}
+
+		if(joystick_source_write(&source, events, event_count) < 0){
+			fprintf(stderr, "joystick_source_write(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		written = written + (uint32_t)event_count;
+		if(c == chunk_count){
+			break;
+		}
+
+		const double deadline = bench_now() + 1.0;
+		while(drained < written && bench_now() < deadline)
+		{
+			const size_t drain_count = joystick_reader_drain(&reader, events, 64);
+			for(size_t i = 0; i < drain_count; i++, drained++)
+			{
+				if(events[i].time != drained || events[i].number != drained%4){
+					fprintf(stderr, "bench_check_reader(): drained %u, expected %u \n", events[i].time, drained);
+					exit(EXIT_FAILURE);
+				}
+			}
+		}
+	}
+
+	const double deadline = bench_now() + 1.0;
+	while(joystick_reader_dropped(&reader) < extra && bench_now() < deadline){
+		usleep(1000);
+	}
+
+	const size_t drain_count = joystick_reader_drain(&reader, events, JOYSTICK_RING_SIZE + extra);
+	int error = drained != written - JOYSTICK_RING_SIZE - extra
+		|| drain_count != JOYSTICK_RING_SIZE
+		|| joystick_reader_dropped(&reader) != extra;
+
+	for(size_t i = 0; i < drain_count; i++){
+		error |= events[i].time != drained + i;
+	}
+
+	if(error){
+		fprintf(stderr, "bench_check_reader(): %zu events of a full ring, %u dropped \n", drain_count, joystick_reader_dropped(&reader));
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_reader_stop(&reader);
+	joystick_source_close(&source);
+	joystick_device_close(&device);
+}
+
+/*
+ * Decode alone, and poll reading the events from a generator through a
+ * pipe until it ends.
+ */
+static void bench_poll(void)
+{
+	struct joystick_source_config config;
+	joystick_source_config_default(&config, JOYSTICK_SOURCE_GENERATOR);
+	config.config_rate = 0;
+	config.config_event_count = BENCH_POLL_EVENTS;
+
+	const uint32_t axis_count = config.config_input_attrib.joystick_axis_count;
+	const uint32_t init_count = axis_count + config.config_input_attrib.joystick_button_count;
+
+	struct js_event *events = calloc(BENCH_POLL_EVENTS, sizeof(struct js_event));
+	if(events == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(size_t e = 0; e < BENCH_POLL_EVENTS; e++)
+	{
+		events[e].time = (uint32_t)(e/1000);
+		events[e].value = (int16_t)(bench_random()*(float)INT16_MAX);
+		events[e].type = JS_EVENT_AXIS;
+		events[e].number = (uint8_t)(e%axis_count);
+	}
+
+	struct joystick_device device;
+	memset(&device, 0, sizeof device);
+	device.input_attrib = config.config_input_attrib;
+
+	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+
+	double best[2] = {1e9, 1e9};
+
+	for(int r = 0; r < BENCH_REPEAT; r++)
+	{
+		double t = bench_now();
+		for(size_t e = 0; e < BENCH_POLL_EVENTS; e += JOYSTICK_EVENT_BUFFER_SIZE)
+		{
+			const size_t remaining = BENCH_POLL_EVENTS - e;
+			joystick_input_value_clear_changed(&input_value);
+			joystick_device_decode(&device, &events[e], remaining < JOYSTICK_EVENT_BUFFER_SIZE ? remaining : JOYSTICK_EVENT_BUFFER_SIZE, &input_value);
+		}
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		struct joystick_source source;
+		if(joystick_source_open(&source, &device, &config) < 0){
+			fprintf(stderr, "joystick_source_open(): error \n");
+			exit(EXIT_FAILURE);
+		}
+
+		/* Poll returns -1 once the generator has ended and the pipe is empty. */
+		t = bench_now();
+		while(joystick_device_poll(&device, &input_value) >= 0);
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+
+		joystick_source_close(&source);
+	}
+
+	char params[64];
+	snprintf(params, sizeof params, "axes=%u events=%d", (unsigned)axis_count, BENCH_POLL_EVENTS);
+	bench_emit("decode", params, "events_per_s", (double)BENCH_POLL_EVENTS/best[0]);
+	bench_emit("poll_pipe", params, "events_per_s", (double)(BENCH_POLL_EVENTS + init_count)/best[1]);
+
+	free(events);
+}
+
+
+/*
+ * Fake /dev/input/ and /sys/class/input/ trees. The jsN nodes are copies
+ * of /dev/null when allowed to create device nodes, so probing them fails
+ * after the same system calls as on a real tree. Otherwise they are
+ * regular files, which the scan of device nodes skips.
+ */
+static int bench_tree_write(const char *path, const char *text)
+{
+	FILE *file = fopen(path, "w");
+	if(file == NULL){
+		return -1;
+	}
+
+	fputs(text, file);
+	return fclose(file);
+}
+
+static int bench_tree_node(const char *path, int *char_node)
+{
+	if(*char_node && mknod(path, S_IFCHR | 0644, makedev(1, 3)) == 0){
+		return 0;
+	}
+
+	*char_node = 0;
+	return bench_tree_write(path, "");
+}
+
+static int bench_tree(char *root, size_t device_count, int create, int *char_node)
+{
+	char path[512];
+	int result = 0;
+
+	const char *dirs[] = {"dev", "sys"};
+	const char *files[] = {"device/name", "device/capabilities/abs", "device/capabilities/key"};
+
+	/* 6 axes and 17 buttons from BTN_MISC. */
+	char key[64];
+	snprintf(key, sizeof key, "1ffff%s\n", sizeof(long) == 8 ? " 0 0 0 0" : " 0 0 0 0 0 0 0 0");
+	const char *texts[] = {"Fake joystick\n", "3f\n", key};
+
+	if(create)
+	{
+		for(size_t d = 0; d < 2; d++){
+			snprintf(path, sizeof path, "%s/%s", root, dirs[d]);
+			result |= mkdir(path, 0755);
+		}
+	}
+
+	for(size_t n = 0; n < device_count; n++)
+	{
+		const char *nodes[] = {"js", "event", "mouse"};
+
+		for(size_t k = 0; k < sizeof nodes/sizeof nodes[0]; k++)
+		{
+			snprintf(path, sizeof path, "%s/dev/%s%zu", root, nodes[k], n);
+			result |= create ? (k == 0 ? bench_tree_node(path, char_node) : bench_tree_write(path, "")) : unlink(path);
+		}
+
+		const char *entry_dirs[] = {"", "/device", "/device/capabilities"};
+
+		if(create)
+		{
+			for(size_t k = 0; k < 3; k++){
+				snprintf(path, sizeof path, "%s/sys/js%zu%s", root, n, entry_dirs[k]);
+				result |= mkdir(path, 0755);
+			}
+		}
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			snprintf(path, sizeof path, "%s/sys/js%zu/%s", root, n, files[k]);
+			result |= create ? bench_tree_write(path, texts[k]) : unlink(path);
+		}
+
+		if(!create)
+		{
+			for(size_t k = 3; k > 0; k--){
+				snprintf(path, sizeof path, "%s/sys/js%zu%s", root, n, entry_dirs[k - 1]);
+				result |= rmdir(path);
+			}
+		}
+	}
+
+	if(!create)
+	{
+		for(size_t d = 0; d < 2; d++){
+			snprintf(path, sizeof path, "%s/%s", root, dirs[d]);
+			result |= rmdir(path);
+		}
+
+		result |= rmdir(root);
+	}
+
+	return result;
+}
+
+/*
+ * Time to scan a tree of device_count joysticks, through the device nodes
+ * and through sysfs.
+ */
+static void bench_identify(size_t device_count)
+{
+	assert(device_count <= BENCH_IDENTIFY_DEVICES);
+
+	char root[] = "/tmp/joystick_bench_XXXXXX";
+	int char_node = 1;
+	if(mkdtemp(root) == NULL || bench_tree(root, device_count, 1, &char_node) < 0){
+		fprintf(stderr, "bench_tree(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	char dev_path[64], sys_path[64];
+	snprintf(dev_path, sizeof dev_path, "%s/dev/", root);
+	snprintf(sys_path, sizeof sys_path, "%s/sys/", root);
+
+	struct joystick_input_requirement requirement = {
+		.requirement_axis_count_min = 2,
+		.requirement_button_count_min = 1,
+		.requirement_axis_count_max = JOYSTICK_DEVICE_AXIS_MAX,
+		.requirement_button_count_max = JOYSTICK_DEVICE_BUTTON_MAX,
+	};
+
+	static struct joystick_input_attrib input_attrib[BENCH_IDENTIFY_DEVICES];
+	double best[2] = {1e9, 1e9};
+	size_t found = 0;
+
+	for(int r = 0; r < BENCH_IDENTIFY_REPEAT; r++)
+	{
+		double t = bench_now();
+		joystick_device_identify_path(dev_path, &requirement, input_attrib, BENCH_IDENTIFY_DEVICES);
+		t = bench_now() - t;
+		best[0] = t < best[0] ? t : best[0];
+
+		t = bench_now();
+		found = joystick_sysfs_identify_by_requirement(sys_path, dev_path, &requirement, input_attrib, BENCH_IDENTIFY_DEVICES);
+		t = bench_now() - t;
+		best[1] = t < best[1] ? t : best[1];
+	}
+
+	if(found != device_count){
+		fprintf(stderr, "joystick_sysfs_identify_by_requirement(): found %zu of %zu \n", found, device_count);
+		exit(EXIT_FAILURE);
+	}
+
+	if(bench_tree(root, device_count, 0, &char_node) < 0){
+		fprintf(stderr, "bench_tree(): could not remove %s \n", root);
+	}
+
+	char params[64];
+	snprintf(params, sizeof params, "devices=%zu char_nodes=%d", device_count, char_node);
+	bench_emit("identify_path", params, "us", best[0]*1e6);
+	bench_emit("identify_sysfs", params, "us", best[1]*1e6);
+}
+
+
+struct bench_latency
+{
+	struct joystick_source latency_source;
+
+	/* Monotonic time each event was written, in nanoseconds. */
+	uint64_t *latency_sent;
+
+	/* Events handled by the reader. */
+	uint64_t latency_done;
+};
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec*UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+}
+
+static void *bench_latency_writer(void *arg)
+{
+	struct bench_latency *latency = (struct bench_latency *)arg;
+
+	for(uint64_t e = 0; e < BENCH_LATENCY_EVENTS; e++)
+	{
+		struct js_event event = {
+			.time = (uint32_t)e,
+			.value = (int16_t)(e & 0x7fff),
+			.type = JS_EVENT_AXIS,
+			.number = 0,
+		};
+
+		__atomic_store_n(&latency->latency_sent[e], bench_now_ns(), __ATOMIC_RELEASE);
+
+		if(joystick_source_write(&latency->latency_source, &event, 1) < 0){
+			break;
+		}
+
+		/* One event in flight, so no time is spent queued behind another. */
+		while(__atomic_load_n(&latency->latency_done, __ATOMIC_ACQUIRE) <= e){
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a;
+	const uint64_t y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * Every latency lies in the bucket bounded by its lower bound and the next,
+ * and joydev latencies follow the fastest delivery when it changes.
+ */
+static void bench_check_stats(void)
+{
+	for(uint32_t b = 0; b < JOYSTICK_STATS_LATENCY_BUCKETS; b++)
+	{
+		if(joystick_stats_bucket(joystick_stats_bucket_lower(b)) != b
+		|| (b > 0 && joystick_stats_bucket_lower(b - 1) >= joystick_stats_bucket_lower(b)))
+		{
+			fprintf(stderr, "stats bucket %u: mismatch \n", (unsigned)b);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	const uint32_t last = JOYSTICK_STATS_LATENCY_BUCKETS - 1;
+
+	for(uint64_t latency_us = 0; latency_us < (UINT64_C(1) << 25); latency_us++)
+	{
+		const uint32_t b = joystick_stats_bucket(latency_us);
+
+		if(joystick_stats_bucket_lower(b) > latency_us || (b < last && joystick_stats_bucket_lower(b + 1) <= latency_us)){
+			fprintf(stderr, "stats latency %llu: bucket %u \n", (unsigned long long)latency_us, (unsigned)b);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	if(joystick_stats_bucket(UINT64_MAX) != last){
+		fprintf(stderr, "stats latency max: mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/*
+	 * Ten events 100 ms old, five 2 s old, then one 50 ms old. The ten
+	 * are moved to 50 ms, the five are above the moved range and stay.
+	 */
+	struct joystick_stats *stats = malloc(sizeof(struct joystick_stats));
+	if(stats == NULL){
+		fprintf(stderr, "malloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_stats_create(stats);
+
+	const uint32_t ages_ms[3] = {100, 2000, 50};
+	const size_t counts[3] = {10, 5, 1};
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		struct js_event events[10];
+		memset(events, 0, sizeof events);
+
+		for(size_t e = 0; e < counts[i]; e++){
+			events[e].time = (uint32_t)(bench_now_ns()/1000000) - ages_ms[i];
+		}
+
+		joystick_stats_read(stats, counts[i]*sizeof(struct js_event), events, counts[i]);
+	}
+
+	struct joystick_stats_value value;
+	joystick_stats_snapshot(stats, &value);
+
+	if(value.value_latency[0] != 1
+	|| value.value_latency[joystick_stats_bucket(50000)] != 10
+	|| value.value_latency[joystick_stats_bucket(1900000)] != 5
+	|| value.value_event_count != 16)
+	{
+		fprintf(stderr, "stats joydev latency: mismatch \n");
+		exit(EXIT_FAILURE);
+	}
+
+	free(stats);
+}
+
+static volatile sig_atomic_t bench_signal_count;
+
+static void bench_signal(int signal_number)
+{
+	(void)signal_number;
+	bench_signal_count = bench_signal_count + 1;
+}
+
+/*
+ * A wait until a deadline interrupted by signals every 10 ms still returns
+ * 0 only once the deadline has passed.
+ */
+static void bench_check_wait(void)
+{
+	struct joystick_wait wait;
+	if(joystick_wait_create(&wait) < 0){
+		fprintf(stderr, "joystick_wait_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* No SA_RESTART, so the wait sees EINTR. */
+	struct sigaction action;
+	struct sigaction action_old;
+	memset(&action, 0, sizeof action);
+	action.sa_handler = bench_signal;
+	sigemptyset(&action.sa_mask);
+
+	struct itimerval timer = {{0, 10000}, {0, 10000}};
+	struct itimerval timer_off;
+	memset(&timer_off, 0, sizeof timer_off);
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_nsec = deadline.tv_nsec + 100000000;
+	deadline.tv_sec = deadline.tv_sec + deadline.tv_nsec/1000000000;
+	deadline.tv_nsec = deadline.tv_nsec%1000000000;
+
+	bench_signal_count = 0;
+
+	if(sigaction(SIGALRM, &action, &action_old) < 0 || setitimer(ITIMER_REAL, &timer, NULL) < 0){
+		fprintf(stderr, "setitimer(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	uint64_t tag;
+	const int result = joystick_wait_poll_until(&wait, &tag, 1, &deadline);
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	setitimer(ITIMER_REAL, &timer_off, NULL);
+	sigaction(SIGALRM, &action_old, NULL);
+
+	const int early = now.tv_sec < deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec < deadline.tv_nsec);
+
+	if(result != 0 || early || bench_signal_count == 0){
+		fprintf(stderr, "bench_check_wait(): returned %d %s the deadline after %d signals \n", result, early ? "before" : "after", (int)bench_signal_count);
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_wait_destroy(&wait);
+}
+
+/* Long enough for the threads to be switched many times on one CPU. */
+#define BENCH_SEQLOCK_SECONDS 	1.0
+
+struct bench_seqlock
+{
+	struct joystick_publish *seqlock_publish;
+	struct joystick_stats *seqlock_stats;
+
+	/* Set by the reader when the writer should stop. */
+	int seqlock_stop;
+
+	/* Number of writes, set by the writer thread when it stops. */
+	uint32_t seqlock_writes;
+};
+
+/*
+ * Publish values whose fields all equal the write number, and count reads
+ * of one event each, as fast as possible until stopped.
+ */
+static void *bench_seqlock_writer(void *arg)
+{
+	struct bench_seqlock *seqlock = (struct bench_seqlock *)arg;
+
+	struct joystick_input_value input_value;
+	struct js_event event;
+	memset(&event, 0, sizeof event);
+
+	uint32_t w = 0;
+
+	while(__atomic_load_n(&seqlock->seqlock_stop, __ATOMIC_ACQUIRE) == 0)
+	{
+		w = w + 1;
+
+		for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+			input_value.joystick_axis_value[i] = (float)w;
+		}
+
+		for(uint32_t i = 0; i < JOYSTICK_BUTTON_MAX; i++){
+			input_value.joystick_button_value[i] = (int16_t)(w & 0x7fff);
+		}
+
+		input_value.joystick_event_time = w;
+		input_value.joystick_axis_changed = w;
+		input_value.joystick_button_pressed = w;
+		input_value.joystick_button_released = w;
+		input_value.joystick_button_changed = w;
+
+		joystick_publish_write(seqlock->seqlock_publish, &input_value);
+
+		event.time = (uint32_t)(bench_now_ns()/1000000);
+		joystick_stats_read(seqlock->seqlock_stats, sizeof event, &event, 1);
+	}
+
+	seqlock->seqlock_writes = w;
+
+	return NULL;
+}
+
+/*
+ * Read published values and stats snapshots while another thread writes
+ * them. A copy mixing two writes is reported as torn.
+ */
+static void bench_check_seqlock(void)
+{
+	struct joystick_publish *publish = malloc(sizeof(struct joystick_publish));
+	struct joystick_stats *stats = malloc(sizeof(struct joystick_stats));
+	if(publish == NULL || stats == NULL){
+		fprintf(stderr, "malloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	joystick_publish_create(publish);
+	joystick_stats_create(stats);
+
+	struct bench_seqlock seqlock = {publish, stats, 0, 0};
+
+	pthread_t thread;
+	if(pthread_create(&thread, NULL, bench_seqlock_writer, &seqlock) != 0){
+		fprintf(stderr, "pthread_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	uint32_t sequence_last = 0;
+	const double deadline = bench_now() + BENCH_SEQLOCK_SECONDS;
+
+	while(bench_now() < deadline)
+	{
+		struct joystick_input_value input_value;
+		const uint32_t sequence = joystick_publish_read(publish, &input_value);
+		const uint32_t w = input_value.joystick_event_time;
+
+		int torn = sequence != w || sequence < sequence_last
+			|| input_value.joystick_axis_changed != w
+			|| input_value.joystick_button_pressed != w
+			|| input_value.joystick_button_released != w
+			|| input_value.joystick_button_changed != w;
+
+		for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+			torn |= input_value.joystick_axis_value[i] != (float)w;
+		}
+
+		for(uint32_t i = 0; i < JOYSTICK_BUTTON_MAX; i++){
+			torn |= input_value.joystick_button_value[i] != (int16_t)(w & 0x7fff);
+		}
+
+		struct joystick_stats_value value;
+		joystick_stats_snapshot(stats, &value);
+
+		uint64_t latency_count = 0;
+		for(uint32_t i = 0; i < JOYSTICK_STATS_LATENCY_BUCKETS; i++){
+			latency_count = latency_count + value.value_latency[i];
+		}
+
+		torn |= value.value_event_count != value.value_read_count
+			|| value.value_byte_count != value.value_read_count*sizeof(struct js_event)
+			|| value.value_read_events[0] != value.value_read_count
+			|| latency_count != value.value_read_count;
+
+		if(torn){
+			fprintf(stderr, "bench_check_seqlock(): torn read of write %u, %llu stats reads \n", w, (unsigned long long)value.value_read_count);
+			exit(EXIT_FAILURE);
+		}
+
+		sequence_last = sequence;
+	}
+
+	__atomic_store_n(&seqlock.seqlock_stop, 1, __ATOMIC_RELEASE);
+	pthread_join(thread, NULL);
+
+	struct joystick_input_value input_value;
+	if(joystick_publish_read(publish, &input_value) != seqlock.seqlock_writes || sequence_last > seqlock.seqlock_writes){
+		fprintf(stderr, "bench_check_seqlock(): last read %u of %u writes \n", sequence_last, seqlock.seqlock_writes);
+		exit(EXIT_FAILURE);
+	}
+
+	free(stats);
+	free(publish);
+}
+
+/*
+ * Time from an event written to the device until its translated output,
+ * through wait, poll and translate.
+ */
+static void bench_latency(void)
+{
+	struct bench_latency latency;
+	memset(&latency, 0, sizeof latency);
+
+	uint64_t *samples = calloc(BENCH_LATENCY_EVENTS, sizeof(uint64_t));
+	latency.latency_sent = calloc(BENCH_LATENCY_EVENTS, sizeof(uint64_t));
+
+	if(samples == NULL || latency.latency_sent == NULL){
+		fprintf(stderr, "calloc(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_source_config config;
+	joystick_source_config_default(&config, JOYSTICK_SOURCE_STREAM);
+
+	struct joystick_device device;
+	memset(&device, 0, sizeof device);
+
+	struct joystick_wait wait;
+	struct joystick_map map;
+
+	if(joystick_source_open(&latency.latency_source, &device, &config) < 0
+	|| joystick_wait_create(&wait) < 0
+	|| joystick_wait_add_device(&wait, &device, 0) < 0)
+	{
+		fprintf(stderr, "bench_latency(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	if(joystick_map_create(&map, device.input_attrib.joystick_axis_count, 6) < 0){
+		fprintf(stderr, "joystick_map_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	pthread_t thread;
+	if(pthread_create(&thread, NULL, bench_latency_writer, &latency) != 0){
+		fprintf(stderr, "pthread_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+
+	float output[JOYSTICK_MAP_OUTPUT_MAX];
+	volatile float sink = 0.0f;
+
+	uint64_t e = 0;
+	while(e < BENCH_LATENCY_EVENTS)
+	{
+		uint64_t tag;
+		if(joystick_wait_poll(&wait, &tag, 1, -1) < 0){
+			break;
+		}
+
+		if(joystick_device_poll(&device, &input_value) <= 0){
+			continue;
+		}
+
+		joystick_map_translate(&map, &input_value, output, 6);
+		sink = sink + output[0];
+
+		samples[e] = bench_now_ns() - __atomic_load_n(&latency.latency_sent[e], __ATOMIC_ACQUIRE);
+
+		e = e + 1;
+		__atomic_store_n(&latency.latency_done, e, __ATOMIC_RELEASE);
+	}
+
+	pthread_join(thread, NULL);
+
+	joystick_map_destroy(&map);
+	joystick_wait_destroy(&wait);
+	joystick_device_close(&device);
+	joystick_source_close(&latency.latency_source);
+
+	const size_t sample_count = BENCH_LATENCY_EVENTS - BENCH_LATENCY_WARMUP;
+	qsort(samples + BENCH_LATENCY_WARMUP, sample_count, sizeof(uint64_t), bench_compare);
+
+	const struct {
+		const char *metric;
+		double percentile;
+	} percentiles[] = {
+		{"p50_ns", 0.50},
+		{"p90_ns", 0.90},
+		{"p99_ns", 0.99},
+		{"p999_ns", 0.999},
+		{"max_ns", 1.0},
+	};
+
+	char params[64];
+	snprintf(params, sizeof params, "events=%zu", sample_count);
+
+	for(size_t p = 0; p < sizeof percentiles/sizeof percentiles[0]; p++)
+	{
+		const size_t index = (size_t)(percentiles[p].percentile*(double)(sample_count - 1));
+		bench_emit("latency_event_to_output", params, percentiles[p].metric, (double)samples[BENCH_LATENCY_WARMUP + index]);
+	}
+
+	free(latency.latency_sent);
+	free(samples);
+}
+
+/*
+ * Suites to run, all if none are named.
+ */
+static int bench_selected(int args, char *argv[], const char *suite)
+{
+	int named = 0;
+
+	for(int i = 1; i < args; i++)
+	{
+		if(argv[i][0] == '-'){
+			continue;
+		}
+
+		named = 1;
+		if(strcmp(argv[i], suite) == 0){
+			return 1;
+		}
+	}
+
+	return !named;
+}
+
+int main(int args, char *argv[])
+{
+	for(int i = 1; i < args; i++)
+	{
+		if(strcmp(argv[i], "-j") == 0){
+			bench_json = 1;
+		}
+		else if(argv[i][0] == '-'){
+			fprintf(stderr, "Usage: %s [-j] [map | translate | poll | identify | latency]... \n", argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	srand(1);
+
+	long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t thread_count = cpu_count > 0 ? (size_t)cpu_count : 1;
+
+	const uint32_t sizes[][2] = {
+		{6, 6},
+		{8, 4},
+		{16, 16},
+		{32, 32},
+	};
+
+	if(bench_selected(args, argv, "map"))
+	{
+		bench_check_packed();
+		bench_check_sparse();
+
+		for(size_t i = 0; i < sizeof sizes/sizeof sizes[0]; i++){
+			bench_translate_batch(sizes[i][0], sizes[i][1], thread_count);
+		}
+
+		for(size_t i = 0; i < sizeof sizes/sizeof sizes[0]; i++){
+			bench_translate_incremental(sizes[i][0], sizes[i][1]);
+		}
+
+		bench_translate_fixed();
+
+		bench_check_wide();
+		bench_check_filter();
+		bench_curve();
+
+		bench_check_q15();
+		bench_check_state();
+
+		for(size_t i = 0; i < sizeof sizes/sizeof sizes[0]; i++){
+			bench_translate_q15(sizes[i][0], sizes[i][1]);
+		}
+
+		const int densities[] = {5, 10, 25, 50};
+
+		for(size_t i = 0; i < sizeof sizes/sizeof sizes[0]; i++)
+		{
+			for(size_t k = 0; k < sizeof densities/sizeof densities[0]; k++){
+				bench_translate_sparse(sizes[i][0], sizes[i][1], densities[k]);
+			}
+		}
+	}
+
+	if(bench_selected(args, argv, "translate")){
+		bench_translate_sweep();
+	}
+
+	if(bench_selected(args, argv, "poll"))
+	{
+		bench_check_shm();
+		bench_check_evdev();
+		bench_check_record();
+		bench_check_hotplug();
+		bench_check_reader();
+		bench_poll();
+	}
+
+	if(bench_selected(args, argv, "identify"))
+	{
+		const size_t device_counts[] = {1, 8, 64};
+
+		for(size_t i = 0; i < sizeof device_counts/sizeof device_counts[0]; i++){
+			bench_identify(device_counts[i]);
+		}
+	}
+
+	if(bench_selected(args, argv, "latency"))
+	{
+		bench_check_stats();
+		bench_check_seqlock();
+		bench_check_wait();
+		bench_latency();
+	}
+
+	return 0;
+}
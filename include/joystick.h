@@ -28,9 +28,30 @@ extern "C"{
 
 #define JOYSTICK_NAME_LENGTH 128
 
+/* 
+ * Axes and buttons held by joystick_input_value. Poll, decode, state, 
+ * q15 values, curves, filters and maps only see the axes and buttons 
+ * below these, the rest of a wider device is dropped. Read them with 
+ * joystick_input_dynamic and map a window of at most JOYSTICK_AXIS_MAX 
+ * of its axes with joystick_map_translate_array. 
+ */
 #define JOYSTICK_AXIS_MAX 	32
 #define JOYSTICK_BUTTON_MAX 	32
 
+/* 
+ * Largest device that can be opened, joydev numbers axes and buttons 
+ * with 8 bits and has at most ABS_CNT axes. Use joystick_input_dynamic 
+ * for the axes and buttons above JOYSTICK_AXIS_MAX and JOYSTICK_BUTTON_MAX. 
+ */
+#define JOYSTICK_DEVICE_AXIS_MAX 	64
+#define JOYSTICK_DEVICE_BUTTON_MAX 	255
+
+/* Maxium number of events read from the kernel in one poll. */
+#define JOYSTICK_EVENT_BUFFER_SIZE 128
+
+/* Used to keep data written by different threads apart. */
+#define JOYSTICK_CACHE_LINE_SIZE 64
+
 #ifdef JOYSTICK_LOG_FD
 extern FILE *joystick_log_fd;
 #endif 
@@ -53,18 +74,70 @@ struct joystick_input_requirement
 	uint8_t requirement_button_count_max;
 };
 
+/* 
+ * Holds the first JOYSTICK_AXIS_MAX axes and JOYSTICK_BUTTON_MAX buttons 
+ * of a device, the rest are left out. 
+ */
+
 struct joystick_input_value
 {
 	float 	joystick_axis_value[JOYSTICK_AXIS_MAX];
 	int16_t joystick_button_value[JOYSTICK_BUTTON_MAX];
+
+	/* Kernel time in milliseconds of the last event written to the value. */
+	uint32_t joystick_event_time;
+
+	/* Bit n is set if axis n was written by the last poll that returned new values. */
+	uint32_t joystick_axis_changed;
+
+	/* 
+	 * Bit n is set if button n was pressed or released during the last poll 
+	 * that returned new values. A tap within one poll sets both. Changed 
+	 * is pressed or released. 
+	 */
+	uint32_t joystick_button_pressed;
+	uint32_t joystick_button_released;
+	uint32_t joystick_button_changed;
 }; 
 
 
+struct joystick_curve;
+struct joystick_filter;
+struct joystick_record;
+struct joystick_stats;
+
+/* 
+ * Opens nodes that are not joydev nodes, etc. event sources of a test 
+ * harness. The function opens device_path non-blocking, fills 
+ * input_attrib with the path included and returns the file descriptor, 
+ * -1 if the node is not a joystick. 
+ */
+struct joystick_device_opener
+{
+	int (*opener_function)(const char *device_path, struct joystick_input_attrib *input_attrib, void *opener_arg);
+	void *opener_arg;
+};
+
 struct joystick_device
 {
 	int device_fd;
 	struct joystick_input_attrib input_attrib;
 	//struct joystick_input_value input_value;
+
+	/* Response curve used by decode, NULL for linear. See joystick_curve.h */
+	const struct joystick_curve *device_curve;
+
+	/* Axis filters run by decode after the curve, NULL for none. See joystick_filter.h */
+	struct joystick_filter *device_filter;
+
+	/* Every event read is appended to the recording, NULL for none. See joystick_record.h */
+	struct joystick_record *device_record;
+
+	/* Read counters, NULL for none. See joystick_stats.h */
+	struct joystick_stats *device_stats;
+
+	/* Used by reopen, NULL for joydev. */
+	const struct joystick_device_opener *device_opener;
 };
 
 
@@ -94,6 +167,83 @@ uint32_t joystick_device_axis_count(struct joystick_device *device);
 int joystick_device_poll(struct joystick_device *device, struct joystick_input_value *input_value);
 
 
+/* 
+ * Read raw events with their kernel timestamps. Events are returned 
+ * in the order they were produced. js_event.time is in milliseconds. 
+ *
+ * @param device Initialized device. 
+ *
+ * @param events Will be filled with the read events. 
+ *
+ * @param event_max Maxium elements events fits. 
+ *
+ * @return Returns number of events read, 0 on nothing, but success. -1 on failure or end of file. 
+ */
+
+int joystick_device_read(struct joystick_device *device, struct js_event *events, size_t event_max);
+
+
+/* 
+ * Use a response curve for the axis values written by poll and decode. 
+ * Stays set when the device is reopened. 
+ *
+ * @param device Device. 
+ *
+ * @param curve Curve, or NULL for linear. 
+ */
+
+void joystick_device_use_curve(struct joystick_device *device, const struct joystick_curve *curve);
+
+
+/* 
+ * Filter the axis values written by poll and decode. The filter 
+ * holds state and must not be shared with other devices. 
+ *
+ * @param device Device. 
+ *
+ * @param filter Filter, or NULL for none. 
+ */
+
+void joystick_device_use_filter(struct joystick_device *device, struct joystick_filter *filter);
+
+
+/* 
+ * Record every event read from the device, by poll or read. 
+ *
+ * @param device Device. 
+ *
+ * @param record Created recorder, or NULL to stop recording. 
+ */
+
+void joystick_device_use_record(struct joystick_device *device, struct joystick_record *record);
+
+
+/* 
+ * Apply events to value, as done by poll. Bits of written axes and 
+ * button edges are added to the changed masks, clear them with 
+ * joystick_input_value_clear_changed before decoding a new batch. 
+ * INIT events set the state without edges. Events of axes and buttons 
+ * at or above JOYSTICK_AXIS_MAX and JOYSTICK_BUTTON_MAX are dropped. 
+ *
+ * @param device Initialized device. 
+ *
+ * @param events Events returned by read. 
+ *
+ * @param event_count Number of events. 
+ *
+ * @param value Where decoded data will be stored.  
+ */
+
+void joystick_device_decode(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_value *input_value);
+
+
+/* 
+ * Clear the changed axis and button masks of value. 
+ */
+
+void joystick_input_value_clear_changed(struct joystick_input_value *input_value);
+
+
 /* 
  * Used for identifying joystick devices 
  *
@@ -126,6 +276,55 @@ size_t joystick_device_identify(struct joystick_input_attrib *input_attrib, size
 size_t joystick_device_identify_by_requirement(struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max);
 
 
+/* 
+ * Same as identify_by_requirement, but searches another directory than /dev/input/ 
+ *
+ * @param dev_path Directory with joystick device nodes. 
+ *
+ * @return returns 0 if no devices are found. Otherwise number of devices found. 
+ */
+
+size_t joystick_device_identify_path(const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max);
+
+
+/* 
+ * Same as identify_path, but the devices are probed concurrently by a 
+ * pool of worker threads. A device that does not answer within the 
+ * timeout is left out. Devices are reported in the same order as by 
+ * identify_path. 
+ *
+ * @param worker_count Number of worker threads. 
+ *
+ * @param timeout_ms Time each device may take to open and answer. 
+ *
+ * @return returns 0 if no devices are found. Otherwise number of devices found. 
+ */
+
+size_t joystick_device_identify_parallel(const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max, size_t worker_count, int timeout_ms);
+
+
+/* 
+ * Check if a device satisfies the requirements. 
+ *
+ * @return Returns 1 if satisfied, else -1 
+ */
+
+int joystick_input_requirement_satisfied(const struct joystick_input_requirement *input_requirement, const struct joystick_input_attrib *input_attrib);
+
+
+/* 
+ * Open a device node, read its attributes and close it again. 
+ *
+ * @param device_path System path to joystick device. 
+ *
+ * @param input_attrib will be filled with the results. 
+ *
+ * @return Returns 0 on success. -1 if it is not a joystick device. 
+ */
+
+int joystick_device_probe(const char *device_path, struct joystick_input_attrib *input_attrib);
+
+
 /* 
  * Check if joystick is open
  * 
@@ -151,6 +350,29 @@ int joystick_device_is_open(struct joystick_device *device);
 
 int joystick_device_open(struct joystick_device *device, const char *device_path);
 
+/* 
+ * Same as joystick_device_open, but the node is opened by opener, also 
+ * when the device is reopened. 
+ *
+ * @param opener Opener, or NULL for joydev. Must outlive the device. 
+ */
+
+int joystick_device_open_with(struct joystick_device *device, const char *device_path, const struct joystick_device_opener *opener);
+
+/*
+ * Initialize joystick device on any readable file descriptor, etc. a pipe
+ * fed with struct js_event records. No curve, filter, record or stats is
+ * attached.
+ *
+ * @param device joystick device that should be initialized.
+ *
+ * @param fd Non-blocking file descriptor. Owned by device.
+ *
+ * @param input_attrib Attributes the device reports.
+ */
+
+void joystick_device_create(struct joystick_device *device, int fd, const struct joystick_input_attrib *input_attrib);
+
 /* 
  * Reopen joystick device. 
  * 
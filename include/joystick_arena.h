@@ -0,0 +1,65 @@
+/*
+ * Decription:
+ * 	Bump allocator over memory given by the caller. Used to size state
+ * 	to the device once, so polling never allocates.
+ * Notes:
+ *	- Memory is only given back all at once with reset.
+ *	- The arena does not own the memory.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_ARENA_H_
+#define JOYSTICK_ARENA_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+struct joystick_arena
+{
+	uint8_t *arena_memory;
+	size_t arena_size;
+	size_t arena_used;
+};
+
+
+/*
+ * Create arena over memory.
+ *
+ * @param arena Uninitialized arena.
+ *
+ * @param memory Memory to allocate from, etc. a static array.
+ *
+ * @param size Bytes in memory.
+ */
+
+void joystick_arena_create(struct joystick_arena *arena, void *memory, size_t size);
+
+/*
+ * Allocate from the arena.
+ *
+ * @param size Bytes to allocate.
+ *
+ * @param align Alignment, power of two.
+ *
+ * @return Returns zeroed memory. NULL if the arena is full.
+ */
+
+void *joystick_arena_alloc(struct joystick_arena *arena, size_t size, size_t align);
+
+/*
+ * Give back everything allocated from the arena.
+ */
+
+void joystick_arena_reset(struct joystick_arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
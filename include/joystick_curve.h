@@ -0,0 +1,144 @@
+/*
+ * Decription:
+ * 	Per axis response curve applied before the linear map: deadzone,
+ * 	saturation, expo or a custom curve, and inversion. Each configured
+ * 	axis is compiled into a table indexed by the raw js_event value, so
+ * 	converting an event costs one load.
+ * Notes:
+ *	- A table is 65536 floats, 256 KiB, and is only allocated for axes
+ *	  that have a curve. Other axes are converted linearly as before.
+ *	- Attach the curve to a device with joystick_device_use_curve, poll
+ *	  and decode then write curved values. The curve must outlive the
+ *	  device, or be detached first.
+ *	- The curve is read, never written, by decode, so one curve can be
+ *	  shared by any number of devices. Do not change it while they poll.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_CURVE_H_
+#define JOYSTICK_CURVE_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdint.h>
+
+#include "joystick.h"
+
+/* Number of raw axis values, INT16_MIN to INT16_MAX. */
+#define JOYSTICK_CURVE_TABLE_SIZE 65536
+
+
+/*
+ * Magnitude m in [0, 1] goes through:
+ *
+ * 	deadzone:   m <= deadzone is 0.
+ * 	saturation: [deadzone, saturation] is stretched to [0, 1], larger is 1.
+ * 	curve:      (1 - expo)*m + expo*m^3, or function(m, function_arg).
+ *
+ * then the sign is restored, inverted if asked and clamped to [-1, 1].
+ */
+
+struct joystick_curve_config
+{
+	/* [0, saturation) */
+	float config_deadzone;
+
+	/* (deadzone, 1] */
+	float config_saturation;
+
+	/* [0, 1], 0 is linear and 1 is cubic. */
+	float config_expo;
+
+	/* Non zero negates the output. */
+	int config_invert;
+
+	/* Replaces expo if not NULL. Called only while compiling. */
+	float (*config_function)(float magnitude, void *function_arg);
+	void *config_function_arg;
+};
+
+struct joystick_curve
+{
+	/* Output for raw value v is at [v - INT16_MIN]. NULL for linear axes. */
+	float *curve_table[JOYSTICK_AXIS_MAX];
+};
+
+
+/*
+ * Fill config with the linear curve. No deadzone, saturation at 1.
+ *
+ * @param config Config to fill.
+ */
+
+void joystick_curve_config_default(struct joystick_curve_config *config);
+
+/*
+ * Compute the curve for a single raw value without a table.
+ *
+ * @param config Curve config.
+ *
+ * @param value Raw js_event axis value.
+ *
+ * @return Value in [-1, 1].
+ */
+
+float joystick_curve_evaluate(const struct joystick_curve_config *config, int16_t value);
+
+
+/*
+ * Create curve with every axis linear.
+ *
+ * @param curve Uninitialized curve.
+ */
+
+void joystick_curve_create(struct joystick_curve *curve);
+
+/*
+ * Free every table.
+ */
+
+void joystick_curve_destroy(struct joystick_curve *curve);
+
+/*
+ * Compile config into the table of an axis, replacing any previous one.
+ *
+ * @param axis Axis number.
+ *
+ * @return Returns 0 on success. -1 on allocation failure.
+ */
+
+int joystick_curve_set(struct joystick_curve *curve, uint8_t axis, const struct joystick_curve_config *config);
+
+/*
+ * Make an axis linear again.
+ *
+ * @param axis Axis number.
+ */
+
+void joystick_curve_clear(struct joystick_curve *curve, uint8_t axis);
+
+/*
+ * Convert a raw value of an axis, as done by decode.
+ *
+ * @return Value in [-1, 1].
+ */
+
+static inline float joystick_curve_apply(const struct joystick_curve *curve, uint8_t axis, int16_t value)
+{
+	const float *table = curve->curve_table[axis];
+	if(table != NULL){
+		return table[(int32_t)value - INT16_MIN];
+	}
+
+	/* Map INT16_T range to float [-1, 1] */
+	return ((float)value)/((float)INT16_MAX);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * Decription:
+ * 	Serve many joystick devices from one thread. All devices are registered
+ * 	in one wait set and only the devices that are ready are read.
+ * Notes:
+ *	- The set owns the devices and the latest input value of each device.
+ *	- Devices are identified by the index returned from open. The index is
+ *	  stable for the lifetime of the set, also when the device is disconnected.
+ *	- A disconnected device is reported once with result -1. Use reopen to
+ *	  bring disconnected devices back, or watch a hotplug monitor to have
+ *	  them reopened as soon as their device node reappears.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_DEVICE_SET_H_
+#define JOYSTICK_DEVICE_SET_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+#include "joystick_hotplug.h"
+#include "joystick_wait.h"
+
+#define JOYSTICK_DEVICE_SET_MAX 	64
+
+/* Wait tag of the watched hotplug monitor. */
+#define JOYSTICK_DEVICE_SET_TAG_HOTPLUG 	(UINT64_MAX - 1)
+
+
+struct joystick_device_set
+{
+	struct joystick_wait set_wait;
+	struct joystick_hotplug *set_hotplug;
+
+	/* 1 while the hotplug monitor may have events that were not reported yet. */
+	int set_hotplug_pending;
+
+	size_t set_device_count;
+	struct joystick_device set_device[JOYSTICK_DEVICE_SET_MAX];
+	struct joystick_input_value set_input_value[JOYSTICK_DEVICE_SET_MAX];
+};
+
+struct joystick_device_update
+{
+	/* Index of the device in the set. */
+	size_t update_index;
+
+	/* 1 if there are new values, -1 if the device was disconnected, 2 if it was reconnected. */
+	int update_result;
+};
+
+
+/*
+ * Create empty device set.
+ *
+ * @param set Uninitialized device set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_device_set_create(struct joystick_device_set *set);
+
+/*
+ * Close all devices and destroy the set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_device_set_destroy(struct joystick_device_set *set);
+
+
+/*
+ * Open joystick device and add it to the set.
+ *
+ * @param set Initialized device set.
+ *
+ * @param device_path System path to joystick device. Usually /dev/input/jsN
+ *
+ * @return Returns index of the device on success. -1 on failure or if the set is full.
+ */
+
+int joystick_device_set_open(struct joystick_device_set *set, const char *device_path);
+
+/*
+ * Same as joystick_device_set_open, but the node is opened by opener. See
+ * joystick_device_open_with.
+ */
+
+int joystick_device_set_open_with(struct joystick_device_set *set, const char *device_path, const struct joystick_device_opener *opener);
+
+/*
+ * Try to reopen every disconnected device in the set.
+ *
+ * @return Returns number of devices that were reopened.
+ */
+
+size_t joystick_device_set_reopen(struct joystick_device_set *set);
+
+
+/*
+ * Reopen disconnected devices whose device node was added. Devices still
+ * open at a removed node are closed first, so a node replaced between two
+ * calls to joystick_hotplug_process is reopened.
+ *
+ * @param events Events returned by joystick_hotplug_process.
+ *
+ * @param event_count Number of events.
+ *
+ * @return Returns number of devices that were reopened.
+ */
+
+size_t joystick_device_set_hotplug(struct joystick_device_set *set, const struct joystick_hotplug_event *events, size_t event_count);
+
+/*
+ * Let poll process a hotplug monitor and reopen devices as they reappear.
+ * Reopened devices are reported with result 2, devices closed because their
+ * node was removed with result -1. Lost inotify events are rescanned at once.
+ * A monitor that keeps failing, as after its directory was removed, is no
+ * longer watched and set_hotplug is NULL again.
+ *
+ * @param hotplug Initialized hotplug monitor. Must outlive the set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_device_set_watch(struct joystick_device_set *set, struct joystick_hotplug *hotplug);
+
+
+/*
+ * Get device in set.
+ *
+ * @param index Index returned by open.
+ */
+
+struct joystick_device *joystick_device_set_device(struct joystick_device_set *set, size_t index);
+
+/*
+ * Get latest input value of device in set.
+ *
+ * @param index Index returned by open.
+ */
+
+struct joystick_input_value *joystick_device_set_value(struct joystick_device_set *set, size_t index);
+
+
+/*
+ * Block until any device has input, then read only the ready devices.
+ * Devices and hotplug events that do not fit in updates are left for the
+ * next poll, which does not block while hotplug events are left.
+ *
+ * @param set Initialized device set.
+ *
+ * @param updates Will be filled with one entry per device that changed.
+ *
+ * @param update_max Maxium elements updates fits.
+ *
+ * @param timeout_ms Timeout in milliseconds. -1 blocks forever, 0 returns at once.
+ *
+ * @return Returns number of updates, 0 on timeout or wakeup. -1 on failure.
+ */
+
+int joystick_device_set_poll(struct joystick_device_set *set, struct joystick_device_update *updates, size_t update_max, int timeout_ms);
+
+/*
+ * Interrupt a blocked poll. Safe to call from any thread.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_device_set_wakeup(struct joystick_device_set *set);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
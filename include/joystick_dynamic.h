@@ -0,0 +1,115 @@
+/*
+ * Decription:
+ * 	Input value sized to the device, for devices with more axes or
+ * 	buttons than joystick_input_value holds, etc. button boxes and
+ * 	throttles with up to JOYSTICK_DEVICE_BUTTON_MAX buttons.
+ * Notes:
+ *	- Memory comes from a caller arena when the value is created, poll
+ *	  and decode never allocate.
+ *	- Same content as joystick_input_value. Masks are bitsets of 64 bit
+ *	  words, bit n of the set is bit n%64 of word n/64.
+ *	- Axis values are float arrays and can be given to the translate
+ *	  array functions of the maps. A map takes up to JOYSTICK_MAP_INPUT_MAX
+ *	  inputs, wider devices pass the window of axes the map uses.
+ *	- Response curves and filters apply to the first JOYSTICK_AXIS_MAX axes.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_DYNAMIC_H_
+#define JOYSTICK_DYNAMIC_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+#include "joystick_arena.h"
+
+/* Words in a bitset of count bits. */
+#define JOYSTICK_DYNAMIC_WORDS(count) 	(((size_t)(count) + 63)/64)
+
+
+struct joystick_input_dynamic
+{
+	uint32_t dynamic_axis_count;
+	uint32_t dynamic_button_count;
+
+	/* Kernel time in milliseconds of the last event written to the value. */
+	uint32_t dynamic_event_time;
+
+	float *dynamic_axis_value;
+	int16_t *dynamic_button_value;
+
+	/* Axes written by the last poll that returned new values. */
+	uint64_t *dynamic_axis_changed;
+
+	/* Button edges during the last poll that returned new values. */
+	uint64_t *dynamic_button_pressed;
+	uint64_t *dynamic_button_released;
+	uint64_t *dynamic_button_changed;
+};
+
+
+/*
+ * Bytes of arena a value for the device needs, alignment included.
+ *
+ * @param input_attrib Attributes of the device.
+ */
+
+size_t joystick_input_dynamic_size(const struct joystick_input_attrib *input_attrib);
+
+/*
+ * Create zeroed value sized to the device.
+ *
+ * @param input_dynamic Uninitialized value.
+ *
+ * @param input_attrib Attributes of the device.
+ *
+ * @param arena Arena to allocate from.
+ *
+ * @return Returns 0 on success. -1 if the arena is full.
+ */
+
+int joystick_input_dynamic_create(struct joystick_input_dynamic *input_dynamic, const struct joystick_input_attrib *input_attrib, struct joystick_arena *arena);
+
+/*
+ * Clear the changed axis and button masks.
+ */
+
+void joystick_input_dynamic_clear_changed(struct joystick_input_dynamic *input_dynamic);
+
+/*
+ * Get bit of a mask.
+ *
+ * @return Returns 1 if set, else 0.
+ */
+
+static inline int joystick_input_dynamic_test(const uint64_t *mask, uint32_t bit)
+{
+	return (mask[bit/64] >> (bit%64)) & 1u ? 1 : 0;
+}
+
+
+/*
+ * Same as joystick_device_poll, but every axis and button of the device.
+ *
+ * @return Returns 1 if there are new values, 0 on nothing, but success. -1 on failure.
+ */
+
+int joystick_device_poll_dynamic(struct joystick_device *device, struct joystick_input_dynamic *input_dynamic);
+
+/*
+ * Same as joystick_device_decode, but every axis and button of the device.
+ */
+
+void joystick_device_decode_dynamic(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_dynamic *input_dynamic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
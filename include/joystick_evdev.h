@@ -0,0 +1,169 @@
+/*
+ * Decription:
+ * 	Read joysticks through the evdev interface, /dev/input/eventN,
+ * 	instead of the joydev interface.
+ * Notes:
+ *	- Axes and buttons are numbered the same way joydev numbers them, so
+ *	  maps and layouts such as joystick_map_ps3.h apply to both interfaces.
+ *	- Axis values are normalized to [-1, 1] from the absinfo range of each
+ *	  axis. Values within flat of the center read as 0.
+ *	- Events are collected into a pending value and only published on
+ *	  SYN_REPORT, so a value never holds half of a hardware frame.
+ *	- After SYN_DROPPED the pending frame is discarded and the state is
+ *	  read again from the device at the next SYN_REPORT.
+ *	- Event times are taken from CLOCK_MONOTONIC when the device allows it.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_EVDEV_H_
+#define JOYSTICK_EVDEV_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <linux/input.h>
+
+#include "joystick.h"
+
+struct joystick_stats;
+
+/* Marks an event code that is not mapped to an axis or button. */
+#define JOYSTICK_EVDEV_UNMAPPED 	0xff
+
+
+struct joystick_evdev_axis
+{
+	float axis_center;
+	float axis_flat;
+
+	/* 1/(half range - flat) */
+	float axis_scale;
+};
+
+struct joystick_evdev
+{
+	int evdev_fd;
+	struct joystick_input_attrib evdev_input_attrib;
+
+	/* Set after SYN_DROPPED until the next SYN_REPORT. */
+	int evdev_dropped;
+
+	/* Axis number of every ABS code and button number of every key from BTN_MISC. */
+	uint8_t evdev_axis_map[ABS_CNT];
+	uint8_t evdev_button_map[KEY_CNT - BTN_MISC];
+
+	/* Event code of every axis and button number. */
+	uint16_t evdev_axis_code[JOYSTICK_AXIS_MAX];
+	uint16_t evdev_button_code[JOYSTICK_BUTTON_MAX];
+
+	struct joystick_evdev_axis evdev_axis[JOYSTICK_AXIS_MAX];
+
+	/* Frame being collected until SYN_REPORT. */
+	struct joystick_input_value evdev_pending;
+
+	/* Last complete frame, the pending frame is reset to it on SYN_DROPPED. */
+	struct joystick_input_value evdev_frame;
+
+	/* Read counters, NULL for none. See joystick_stats.h */
+	struct joystick_stats *evdev_stats;
+};
+
+
+/*
+ * Open evdev device and number its axes and buttons.
+ *
+ * @param evdev Uninitialized evdev device.
+ *
+ * @param device_path System path to evdev device, etc. /dev/input/event0
+ *
+ * @return Returns 0 on success. -1 on failure or if the device have too many axes or buttons.
+ */
+
+int joystick_evdev_open(struct joystick_evdev *evdev, const char *device_path);
+
+/*
+ * Create evdev device without axes or buttons on any readable file
+ * descriptor, etc. a pipe fed with struct input_event records.
+ *
+ * @param evdev Uninitialized evdev device.
+ *
+ * @param fd Non-blocking file descriptor. Owned by evdev.
+ */
+
+void joystick_evdev_create(struct joystick_evdev *evdev, int fd);
+
+/*
+ * Give the next axis number to an ABS code.
+ *
+ * @param code ABS code, etc. ABS_X.
+ *
+ * @param absinfo Range of the axis.
+ *
+ * @return Returns axis number. -1 if there is no room.
+ */
+
+int joystick_evdev_add_axis(struct joystick_evdev *evdev, uint16_t code, const struct input_absinfo *absinfo);
+
+/*
+ * Give the next button number to a key code.
+ *
+ * @param code Key code from BTN_MISC and up, etc. BTN_SOUTH.
+ *
+ * @return Returns button number. -1 if there is no room.
+ */
+
+int joystick_evdev_add_button(struct joystick_evdev *evdev, uint16_t code);
+
+/*
+ * Close evdev device.
+ *
+ * @return 0 on success. -1 on failure.
+ */
+
+int joystick_evdev_close(struct joystick_evdev *evdev);
+
+/*
+ * Collect stats of the device while it is polled, as joystick_device_use_stats.
+ *
+ * @param stats Created stats, or NULL for none.
+ *
+ * @return Returns 0 on success. -1 if the library is built without JOYSTICK_STATS.
+ */
+
+int joystick_evdev_use_stats(struct joystick_evdev *evdev, struct joystick_stats *stats);
+
+
+/*
+ * Poll new complete frames into value.
+ *
+ * @param value Where the last complete frame will be stored.
+ *
+ * @return Returns 1 if a frame was completed, 0 on nothing, but success. -1 on failure.
+ */
+
+int joystick_evdev_poll(struct joystick_evdev *evdev, struct joystick_input_value *input_value);
+
+/*
+ * Apply events, as done by poll.
+ *
+ * @param events Events read from the device.
+ *
+ * @param event_count Number of events.
+ *
+ * @param value Where the last complete frame will be stored.
+ *
+ * @return Returns 1 if a frame was completed, else 0.
+ */
+
+int joystick_evdev_decode(struct joystick_evdev *evdev, const struct input_event *events, size_t event_count, struct joystick_input_value *input_value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
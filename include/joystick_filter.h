@@ -0,0 +1,147 @@
+/*
+ * Decription:
+ * 	Per axis filters run on every axis event, with the time between
+ * 	events taken from the kernel event time. Used to remove jitter from
+ * 	cheap sticks without smoothing at the application frame rate.
+ * Notes:
+ *	- Filters: first order low-pass, One-Euro and biquad low-pass.
+ *	- An axis holds its value between events. The biquad runs at
+ *	  JOYSTICK_FILTER_BIQUAD_RATE with the previous value held for the
+ *	  samples between events, which is exact for the held input.
+ *	- Event times have millisecond resolution. Events of one axis in the
+ *	  same millisecond are taken as 1 ms apart.
+ *	- State is written on every event, so each device needs its own
+ *	  filter. Attach it with joystick_device_use_filter.
+ *	- INIT events, sent when the device is opened, restart the filter
+ *	  from their value.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_FILTER_H_
+#define JOYSTICK_FILTER_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdint.h>
+
+#include "joystick.h"
+
+/* Sample rate of the biquad, one sample per event time unit. */
+#define JOYSTICK_FILTER_BIQUAD_RATE 1000
+
+/* Held samples run between two events, the filter has settled after more. */
+#define JOYSTICK_FILTER_BIQUAD_STEP_MAX 250
+
+
+enum joystick_filter_type
+{
+	JOYSTICK_FILTER_NONE = 0,
+	JOYSTICK_FILTER_LOW_PASS = 1,
+	JOYSTICK_FILTER_ONE_EURO = 2,
+	JOYSTICK_FILTER_BIQUAD = 3,
+};
+
+struct joystick_filter_config
+{
+	enum joystick_filter_type config_type;
+
+	/* Cutoff frequency in Hz. Minimum cutoff for One-Euro. */
+	float config_cutoff;
+
+	/* One-Euro, cutoff increase per unit/s of speed. */
+	float config_beta;
+
+	/* One-Euro, cutoff in Hz of the speed estimate. */
+	float config_derivative_cutoff;
+
+	/* Biquad quality factor, 0.7071 is Butterworth. */
+	float config_q;
+};
+
+/*
+ * State of one axis, two per cache line.
+ *
+ * 	LOW_PASS: coefficient tau; state y.
+ * 	ONE_EURO: coefficient tau min, beta, tau derivative; state y, dx.
+ * 	BIQUAD:   coefficient b0, a1, a2; state s1, s2, held x.
+ */
+
+struct joystick_filter_axis
+{
+	float axis_coefficient[3];
+	float axis_state[3];
+
+	/* Time of the last event. */
+	uint32_t axis_time;
+
+	uint8_t axis_type;
+
+	/* Set after the first event. */
+	uint8_t axis_started;
+};
+
+struct joystick_filter
+{
+	struct joystick_filter_axis filter_axis[JOYSTICK_AXIS_MAX] __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+};
+
+
+/*
+ * Create filter that passes every axis through.
+ *
+ * @param filter Uninitialized filter.
+ */
+
+void joystick_filter_create(struct joystick_filter *filter);
+
+/*
+ * Fill config with defaults for a filter type. 10 Hz cutoff, One-Euro
+ * with beta 0.01 and a 1 Hz derivative cutoff, Butterworth biquad.
+ */
+
+void joystick_filter_config_default(struct joystick_filter_config *config, enum joystick_filter_type type);
+
+/*
+ * Set the filter of an axis. The axis starts over at its next event.
+ *
+ * @param axis Axis number.
+ */
+
+void joystick_filter_set(struct joystick_filter *filter, uint8_t axis, const struct joystick_filter_config *config);
+
+/*
+ * Start every axis over at its next event, etc. after the device is reopened.
+ */
+
+void joystick_filter_reset(struct joystick_filter *filter);
+
+/*
+ * Filter one axis event.
+ *
+ * @param axis Axis number.
+ *
+ * @param value Axis value.
+ *
+ * @param time Event time in milliseconds.
+ *
+ * @return Filtered value.
+ */
+
+float joystick_filter_apply(struct joystick_filter *filter, uint8_t axis, float value, uint32_t time);
+
+/*
+ * Start an axis over from value, as for INIT events.
+ *
+ * @return value.
+ */
+
+float joystick_filter_start(struct joystick_filter *filter, uint8_t axis, float value, uint32_t time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
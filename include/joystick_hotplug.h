@@ -0,0 +1,133 @@
+/*
+ * Decription:
+ * 	Track joystick devices being connected and disconnected by watching
+ * 	the device directory with inotify, instead of rescanning it.
+ * Notes:
+ *	- The directory is scanned once on create. After that the registry of
+ *	  connected joysticks is kept up to date from inotify events only.
+ *	- hotplug_fd becomes readable when there are changes. Add it to a wait
+ *	  set and call process when it is ready.
+ *	- udev may change the permissions of a node after it was created. A node
+ *	  that could not be opened on create is probed again on attribute change.
+ *	- A node that was removed and added again between two calls to process,
+ *	  or that now belongs to another joystick, is reported as a remove
+ *	  followed by an add.
+ *	- When the registry is full, new nodes stay pending and are added by a
+ *	  later call to process once a joystick was removed.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_HOTPLUG_H_
+#define JOYSTICK_HOTPLUG_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <linux/limits.h>
+
+#include "joystick.h"
+
+/* Maxium number of joysticks kept in the registry. */
+#define JOYSTICK_HOTPLUG_MAX 	64
+
+/* Nodes jsN with N equal or above this are ignored. */
+#define JOYSTICK_HOTPLUG_NUMBER_MAX 	256
+
+enum joystick_hotplug_type
+{
+	JOYSTICK_HOTPLUG_ADD = 1,
+	JOYSTICK_HOTPLUG_REMOVE = 2,
+};
+
+struct joystick_hotplug_event
+{
+	enum joystick_hotplug_type hotplug_type;
+	struct joystick_input_attrib hotplug_input_attrib;
+};
+
+struct joystick_hotplug
+{
+	int hotplug_fd;
+	int hotplug_watch;
+	char hotplug_dir_path[PATH_MAX];
+
+	/* Bit N set when node jsN changed and the registry is not yet updated. */
+	uint32_t hotplug_dirty[JOYSTICK_HOTPLUG_NUMBER_MAX/32];
+
+	/* Bit N set when node jsN was deleted since the registry was last updated. */
+	uint32_t hotplug_removed[JOYSTICK_HOTPLUG_NUMBER_MAX/32];
+
+	size_t hotplug_count;
+	struct joystick_input_attrib hotplug_registry[JOYSTICK_HOTPLUG_MAX];
+
+	/* Probes the nodes, NULL for joydev. */
+	const struct joystick_device_opener *hotplug_opener;
+};
+
+
+/*
+ * Start watching a device directory.
+ *
+ * @param hotplug Uninitialized hotplug monitor.
+ *
+ * @param dir_path Directory with joystick device nodes. NULL for /dev/input/
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_hotplug_create(struct joystick_hotplug *hotplug, const char *dir_path);
+
+/*
+ * Same as joystick_hotplug_create, but nodes are probed by opening them
+ * with opener.
+ *
+ * @param opener Opener, or NULL for joydev. Must outlive the monitor.
+ */
+
+int joystick_hotplug_create_with(struct joystick_hotplug *hotplug, const char *dir_path, const struct joystick_device_opener *opener);
+
+/*
+ * Stop watching.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_hotplug_destroy(struct joystick_hotplug *hotplug);
+
+
+/*
+ * Update the registry from pending inotify events. Never blocks.
+ *
+ * @param events Will be filled with the joysticks that were added or removed.
+ *
+ * @param event_max Maxium elements events fits. Changes that did not fit are 
+ * kept, call again while it returns event_max.
+ *
+ * @return Returns number of events, 0 on nothing. -1 on failure or when
+ * inotify events were lost, then every node is marked and the next call
+ * rescans them. After the directory itself was removed every call returns
+ * -1, destroy and create the monitor again.
+ */
+
+int joystick_hotplug_process(struct joystick_hotplug *hotplug, struct joystick_hotplug_event *events, size_t event_max);
+
+
+/*
+ * Same as joystick_device_identify_by_requirement, but answered from the
+ * registry without touching the file system.
+ *
+ * @return returns 0 if no devices are found. Otherwise number of devices found.
+ */
+
+size_t joystick_hotplug_identify_by_requirement(struct joystick_hotplug *hotplug, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,9 +24,30 @@ extern "C"{
 
 #include <joystick.h>
 
+/* 
+ * Maps stay sized for JOYSTICK_AXIS_MAX inputs. Devices with more axes 
+ * map up to that many of them with translate_array on the dynamic value. 
+ */
 #define JOYSTICK_MAP_INPUT_MAX  JOYSTICK_AXIS_MAX
 #define JOYSTICK_MAP_OUTPUT_MAX  JOYSTICK_AXIS_MAX
 
+/* Default number of incremental translates between full recomputes. */
+#define JOYSTICK_MAP_INCREMENTAL_REFRESH 256
+
+/* 
+ * Full recompute when at least 1/n of the inputs changed. Applying 
+ * deltas only beats a full translate for few changed axes, in the 
+ * bench from about 16 inputs with 2 changed. 
+ */
+#define JOYSTICK_MAP_INCREMENTAL_SHARE 4
+
+/* 
+ * Maps of at most this many elements are always translated in full, 
+ * as a full translate is as fast. At -O3 the bench breaks even at 8x8 
+ * and applies deltas twice as fast from 10x10. 
+ */
+#define JOYSTICK_MAP_INCREMENTAL_SIZE 64
+
 
 /* 
  * Joystick input map.
@@ -59,6 +80,21 @@ struct joystick_map
 	float map_offset[JOYSTICK_MAP_OUTPUT_MAX];
 };
 
+/* 
+ * Outputs kept between incremental translates. 
+ */
+
+struct joystick_map_incremental
+{
+	/* x and O of the last translate. */
+	float incremental_input[JOYSTICK_MAP_INPUT_MAX];
+	float incremental_output[JOYSTICK_MAP_OUTPUT_MAX];
+
+	/* Translates since the last full recompute. */
+	uint32_t incremental_count;
+	uint32_t incremental_refresh;
+};
+
 /* 
 *  If the map is created with INPUT_COUNT And OUTPUT_COUNT must the OUTPUT_LENGTH, OUTPUT_SCALE_LENGTH be equal OUTPUT_COUNT. 
 *  Will assert if not.
@@ -74,10 +110,10 @@ struct joystick_map
  * @param output_count Number of outputs to map. Etc, the required inputs to the application. 
  * 
  * @return Return -1 if the input_count or output_count is not between (inclusive) 1 and JOYSTICK_MAP_INPUT_MAX
- * or JOYSTICK_MAP_OUTPUT_MAX. 
+ * or JOYSTICK_MAP_OUTPUT_MAX. Devices with more axes map a window of their joystick_input_dynamic axes. 
  */
 
-void joystick_map_create(struct joystick_map * const map, const uint32_t input_count, const uint32_t output_count);
+int joystick_map_create(struct joystick_map * const map, const uint32_t input_count, const uint32_t output_count);
 void joystick_map_destroy(struct joystick_map * const map);
 
 
@@ -85,6 +121,43 @@ void joystick_map_transform(struct joystick_map * const map, const uint32_t inpu
 
 void joystick_map_translate(struct joystick_map * const map, struct joystick_input_value *input_value,  float * const output, const uint32_t output_length);
 
+/* 
+ * Translate from a plain array of input_count axis values, etc. 
+ * dynamic_axis_value of joystick_input_dynamic, or any window of it 
+ * on devices with more axes than a map takes. 
+ */
+
+void joystick_map_translate_array(struct joystick_map * const map, const float *input, float * const output, const uint32_t output_length);
+
+
+/* 
+ * Create incremental state. The first translate is a full recompute. 
+ *
+ * @param incremental Uninitialized incremental state. 
+ *
+ * @param refresh Number of translates between full recomputes, bounds the 
+ * float error that builds up from adding deltas. 
+ */
+
+void joystick_map_incremental_create(struct joystick_map_incremental * const incremental, const uint32_t refresh);
+
+/* 
+ * Force a full recompute on the next translate. Call after the map is changed. 
+ */
+
+void joystick_map_incremental_reset(struct joystick_map_incremental * const incremental);
+
+/* 
+ * Same as joystick_map_translate, but only the axes set in 
+ * input_value->joystick_axis_changed are applied, as delta times 
+ * their column of A. Axes written without setting their bit are 
+ * picked up at the next full recompute. Falls back to a full translate 
+ * when many axes changed, see JOYSTICK_MAP_INCREMENTAL_SHARE, and 
+ * always for small maps, see JOYSTICK_MAP_INCREMENTAL_SIZE. 
+ */
+
+void joystick_map_translate_incremental(struct joystick_map * const map, struct joystick_map_incremental * const incremental, struct joystick_input_value *input_value, float * const output, const uint32_t output_length);
+
 
 void joystick_map_print(struct joystick_map * const map, FILE * const output);
 
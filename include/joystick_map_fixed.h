@@ -0,0 +1,98 @@
+#ifndef JOYSTICK_MAP_FIXED_H
+#define JOYSTICK_MAP_FIXED_H
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+
+/*
+ * Decription:
+ * 	Translate functions generated for a map whose shape and elements are
+ * 	known at compile time, etc. a fixed 6x6 PS3 layout. The loops are fully
+ * 	unrolled and the zero elements are folded away, so the function is only
+ * 	the nonzero multiply adds.
+ *
+ * Notes:
+ * 	- The matrix and offset must be static const arrays laid out like
+ * 	  map_matrix and map_offset of struct joystick_map, A[input][output].
+ * 	- Terms are summed in the same order as joystick_map_translate, only
+ * 	  the zero terms are left out, so the results are the same for finite
+ * 	  input when the caller is built with -ffp-contract=off as the library
+ * 	  is. Otherwise multiply adds may be fused where the CPU has FMA.
+ * 	- No checks are done on the call, the shape is part of the function.
+ *
+ * Error:
+ * 	None.
+ */
+
+
+#include <stdint.h>
+
+#include <joystick.h>
+#include <joystick_map.h>
+
+
+/*
+ * Define the functions
+ *
+ * 	void name(const struct joystick_input_value *input_value, float *output);
+ * 	void name_array(const float *input, float *output);
+ * 	int name_map(struct joystick_map *map);
+ *
+ * where output is output_count long and name_map creates the same map
+ * as a runtime joystick_map, -1 like joystick_map_create when the shape
+ * is larger than JOYSTICK_MAP_INPUT_MAX by JOYSTICK_MAP_OUTPUT_MAX.
+ *
+ * @param name Function name.
+ *
+ * @param input_count Number of inputs, constant.
+ *
+ * @param output_count Number of outputs, constant.
+ *
+ * @param matrix static const float [input_count][output_count], A.
+ *
+ * @param offset static const float [output_count], b.
+ */
+
+#define JOYSTICK_MAP_FIXED_DEFINE(name, input_count, output_count, matrix, offset) \
+	static inline void name##_array(const float * const input, float * const output) \
+	{ \
+		_Pragma("GCC unroll 32") \
+		for(uint32_t i = 0; i < (output_count); i++) \
+		{ \
+			float o_i = (offset)[i]; \
+			_Pragma("GCC unroll 32") \
+			for(uint32_t j = 0; j < (input_count); j++) \
+			{ \
+				o_i = (matrix)[j][i] != 0.0f ? o_i + input[j]*(matrix)[j][i] : o_i; \
+			} \
+			output[i] = o_i; \
+		} \
+	} \
+	\
+	static inline void name(const struct joystick_input_value * const input_value, float * const output) \
+	{ \
+		name##_array(input_value->joystick_axis_value, output); \
+	} \
+	\
+	static inline int name##_map(struct joystick_map * const map) \
+	{ \
+		if(joystick_map_create(map, (input_count), (output_count)) < 0){ \
+			return -1; \
+		} \
+		for(uint32_t j = 0; j < (input_count); j++){ \
+			joystick_map_transform(map, j, (matrix)[j], (output_count)); \
+		} \
+		for(uint32_t i = 0; i < (output_count); i++){ \
+			map->map_offset[i] = (offset)[i]; \
+		} \
+		return 0; \
+	}
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
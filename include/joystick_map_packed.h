@@ -0,0 +1,135 @@
+#ifndef JOYSTICK_MAP_PACKED_H
+#define JOYSTICK_MAP_PACKED_H
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+
+/*
+ * Decription:
+ * 	Packed form of a joystick_map for fast translation. The matrix is
+ * 	stored sized to the map, aligned, with each input column contiguous
+ * 	over the outputs, and translated with SIMD where the CPU supports it.
+ *
+ * Notes:
+ * 	- Packing copies the map. Pack again after the map is changed.
+ * 	- The kernel is chosen when packing: AVX2 or SSE2 on x86, NEON on ARM,
+ * 	  scalar otherwise.
+ * 	- Every kernel sums the terms in the same order as joystick_map_translate
+ * 	  without fused multiply-add. The map sources are built with
+ * 	  -ffp-contract=off so the scalar path is not fused either, and the
+ * 	  results are the same.
+ *
+ * Error:
+ * 	Assert on logical.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <joystick.h>
+#include <joystick_map.h>
+
+/* Outputs are padded to a multiple of this. */
+#define JOYSTICK_MAP_PACKED_LANES 8
+
+enum joystick_map_kernel
+{
+	JOYSTICK_MAP_KERNEL_AUTO = 0,
+	JOYSTICK_MAP_KERNEL_SCALAR = 1,
+	JOYSTICK_MAP_KERNEL_SSE2 = 2,
+	JOYSTICK_MAP_KERNEL_AVX2 = 3,
+	JOYSTICK_MAP_KERNEL_NEON = 4,
+};
+
+struct joystick_map_packed
+{
+	uint32_t packed_input_count;
+	uint32_t packed_output_count;
+
+	/* Output count rounded up to JOYSTICK_MAP_PACKED_LANES. */
+	uint32_t packed_stride;
+
+	enum joystick_map_kernel packed_kernel;
+
+	/* b followed by one column of A per input, each packed_stride long. */
+	float *packed_matrix;
+};
+
+
+/*
+ * Pack a map using the fastest kernel the CPU supports.
+ *
+ * @param map Created map.
+ *
+ * @param packed Uninitialized packed map.
+ *
+ * @return Returns 0 on success. -1 on allocation failure.
+ */
+
+int joystick_map_pack(struct joystick_map * const map, struct joystick_map_packed * const packed);
+
+/*
+ * Pack a map using a given kernel.
+ *
+ * @param kernel Kernel to use, or JOYSTICK_MAP_KERNEL_AUTO.
+ *
+ * @return Returns 0 on success. -1 on allocation failure or if the CPU lacks the kernel.
+ */
+
+int joystick_map_pack_kernel(struct joystick_map * const map, struct joystick_map_packed * const packed, const enum joystick_map_kernel kernel);
+
+void joystick_map_packed_destroy(struct joystick_map_packed * const packed);
+
+
+/*
+ * Same as joystick_map_translate.
+ */
+
+void joystick_map_packed_translate(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length);
+
+/*
+ * Translate from a plain array of input_count axis values.
+ */
+
+void joystick_map_packed_translate_array(const struct joystick_map_packed * const packed, const float *input, float * const output, const uint32_t output_length);
+
+
+/*
+ * Translate many frames in one call. 
+ *
+ * @param input_values frame_count input values, one per frame. 
+ *
+ * @param frame_count Number of frames. 
+ *
+ * @param output frame_count x output_count matrix, frame after frame. 
+ */
+
+void joystick_map_packed_translate_batch(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_values, const size_t frame_count, float * const output);
+
+/*
+ * Same as translate_batch, but the input is stored axis after axis. 
+ *
+ * @param input input_count x frame_count matrix, input[j*frame_count + f] is axis j of frame f. 
+ *
+ * @param output frame_count x output_count matrix, frame after frame. 
+ */
+
+void joystick_map_packed_translate_batch_soa(const struct joystick_map_packed * const packed, const float *input, const size_t frame_count, float * const output);
+
+/*
+ * Same as translate_batch, with the frames split evenly over threads. 
+ *
+ * @param thread_count Number of threads, including the calling thread. 
+ */
+
+void joystick_map_packed_translate_batch_parallel(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_values, const size_t frame_count, float * const output, const size_t thread_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef JOYSTICK_MAP_SPARSE_H
+#define JOYSTICK_MAP_SPARSE_H
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+
+/*
+ * Decription:
+ * 	Sparse form of a joystick_map. Only the nonzero elements of A are
+ * 	stored, row by row, and translate walks only those. Most maps route
+ * 	each input to a few outputs, so this is both smaller and faster than
+ * 	the dense map.
+ *
+ * Notes:
+ * 	- Building copies the map. Build again after the map is changed.
+ * 	- Terms are summed in the same order as joystick_map_translate, only
+ * 	  the zero terms are left out, so the results are the same for finite
+ * 	  input.
+ * 	- joystick_map_compile picks the sparse or the packed form by the
+ * 	  density of the map.
+ *
+ * Error:
+ * 	Assert on logical.
+ */
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <joystick.h>
+#include <joystick_map.h>
+#include <joystick_map_packed.h>
+
+/* Maps with at most one in this many elements nonzero are compiled sparse,
+ * denser maps are faster with the SIMD packed form. */
+#define JOYSTICK_MAP_SPARSE_RATIO 10
+
+struct joystick_map_sparse
+{
+	uint32_t sparse_input_count;
+	uint32_t sparse_output_count;
+	uint32_t sparse_nonzero_count;
+
+	/* b, output_count long. */
+	float *sparse_offset;
+
+	/* Nonzero elements of A, row after row. */
+	float *sparse_value;
+
+	/* Row i is elements row_begin[i] up to row_begin[i + 1]. */
+	uint16_t *sparse_row_begin;
+
+	/* Input of every element. */
+	uint8_t *sparse_column;
+};
+
+enum joystick_map_form
+{
+	JOYSTICK_MAP_FORM_PACKED = 1,
+	JOYSTICK_MAP_FORM_SPARSE = 2,
+};
+
+/*
+ * Map compiled to the form that suits its density.
+ */
+
+struct joystick_map_compiled
+{
+	enum joystick_map_form compiled_form;
+
+	/* Only the one given by compiled_form is used. */
+	struct joystick_map_packed compiled_packed;
+	struct joystick_map_sparse compiled_sparse;
+};
+
+
+/*
+ * Build the sparse form of a map.
+ *
+ * @param map Created map.
+ *
+ * @param sparse Uninitialized sparse map.
+ *
+ * @return Returns 0 on success. -1 on allocation failure.
+ */
+
+int joystick_map_sparse_create(struct joystick_map * const map, struct joystick_map_sparse * const sparse);
+
+void joystick_map_sparse_destroy(struct joystick_map_sparse * const sparse);
+
+/*
+ * Number of bytes allocated for the sparse map.
+ */
+
+size_t joystick_map_sparse_size(const struct joystick_map_sparse * const sparse);
+
+
+/*
+ * Same as joystick_map_translate.
+ */
+
+void joystick_map_sparse_translate(const struct joystick_map_sparse * const sparse, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length);
+
+/*
+ * Translate from a plain array of input_count axis values.
+ */
+
+void joystick_map_sparse_translate_array(const struct joystick_map_sparse * const sparse, const float *input, float * const output, const uint32_t output_length);
+
+
+/*
+ * Compile a map to the sparse form if at most one in
+ * JOYSTICK_MAP_SPARSE_RATIO elements of A is nonzero, else to the
+ * packed form.
+ *
+ * @param map Created map.
+ *
+ * @param compiled Uninitialized compiled map.
+ *
+ * @return Returns 0 on success. -1 on allocation failure.
+ */
+
+int joystick_map_compile(struct joystick_map * const map, struct joystick_map_compiled * const compiled);
+
+void joystick_map_compiled_destroy(struct joystick_map_compiled * const compiled);
+
+/*
+ * Same as joystick_map_translate.
+ */
+
+void joystick_map_compiled_translate(const struct joystick_map_compiled * const compiled, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Decription:
+ * 	Latest input value shared between one writer thread and any number
+ * 	of reader threads, protected by a sequence lock.
+ * Notes:
+ *	- Readers never write to the object, so they do not contend with each
+ *	  other. A read retries only if it overlapped with a write.
+ *	- The object holds no pointers and can be placed in shared memory.
+ *	- Only one thread may write.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_PUBLISH_H_
+#define JOYSTICK_PUBLISH_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdint.h>
+
+#include "joystick.h"
+
+
+struct joystick_publish
+{
+	/* Odd while a write is in progress. */
+	uint32_t publish_sequence __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+
+	struct joystick_input_value publish_value;
+};
+
+
+/*
+ * Create published state with a zeroed value.
+ *
+ * @param publish Uninitialized published state.
+ */
+
+void joystick_publish_create(struct joystick_publish *publish);
+
+/*
+ * Publish new value. Called from the writer thread only.
+ *
+ * @param input_value Value to publish.
+ */
+
+void joystick_publish_write(struct joystick_publish *publish, const struct joystick_input_value *input_value);
+
+/*
+ * Take a consistent copy of the latest published value.
+ *
+ * @param input_value Where the copy will be stored.
+ *
+ * @return Returns the number of writes the copy reflects.
+ */
+
+uint32_t joystick_publish_read(const struct joystick_publish *publish, struct joystick_input_value *input_value);
+
+/*
+ * Number of writes so far. Compare with the result of read to
+ * skip copying a value that have not changed.
+ */
+
+uint32_t joystick_publish_sequence(const struct joystick_publish *publish);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Decription:
+ * 	Integer only input and map path for targets without a FPU, next to
+ * 	the float path. Axis values are kept as the raw int16 event values and
+ * 	mapped with a fixed point matrix.
+ * Notes:
+ *	- Axis and output values are in units of 1/INT16_MAX, the same scale
+ *	  the float path divides by, so raw event values are used as is.
+ *	- Matrix elements have JOYSTICK_Q15_MATRIX_SHIFT fractional bits and
+ *	  the products are summed in 64 bits, so the sum can not overflow. The
+ *	  output is rounded and saturated to [-INT16_MAX, INT16_MAX] once,
+ *	  INT16_MIN inputs included.
+ *	- The outputs are within 1 of the float path times INT16_MAX,
+ *	  clamped to the same range.
+ *	- Only the map is converted from float, once when it is created.
+ *	- Response curves and filters are float and are not used here.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_Q15_H_
+#define JOYSTICK_Q15_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+#include "joystick_map.h"
+
+/* Fractional bits of the matrix elements, elements must be within +-127. */
+#define JOYSTICK_Q15_MATRIX_SHIFT 24
+
+
+struct joystick_input_value_q15
+{
+	/* Raw event values, INT16_MAX is 1.0. */
+	int16_t joystick_axis_value[JOYSTICK_AXIS_MAX];
+	int16_t joystick_button_value[JOYSTICK_BUTTON_MAX];
+
+	/* Kernel time in milliseconds of the last event written to the value. */
+	uint32_t joystick_event_time;
+
+	/* Bit n is set if axis n was written by the last poll that returned new values. */
+	uint32_t joystick_axis_changed;
+
+	/* Button edges during the last poll that returned new values, as in joystick_input_value. */
+	uint32_t joystick_button_pressed;
+	uint32_t joystick_button_released;
+	uint32_t joystick_button_changed;
+};
+
+struct joystick_map_q15
+{
+	uint32_t q15_input_count;
+	uint32_t q15_output_count;
+
+	/* A, JOYSTICK_Q15_MATRIX_SHIFT fractional bits. */
+	int32_t q15_matrix[JOYSTICK_MAP_INPUT_MAX][JOYSTICK_MAP_OUTPUT_MAX];
+
+	/* b, INT16_MAX is 1.0 */
+	int32_t q15_offset[JOYSTICK_MAP_OUTPUT_MAX];
+};
+
+
+/*
+ * Same as joystick_device_poll, but into integer values.
+ *
+ * @return Returns 1 if there are new values, 0 on nothing, but success. -1 on failure.
+ */
+
+int joystick_device_poll_q15(struct joystick_device *device, struct joystick_input_value_q15 *input_value);
+
+/*
+ * Same as joystick_device_decode, but into integer values.
+ */
+
+void joystick_device_decode_q15(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_value_q15 *input_value);
+
+/*
+ * Same as joystick_input_value_clear_changed.
+ */
+
+void joystick_input_value_q15_clear_changed(struct joystick_input_value_q15 *input_value);
+
+
+/*
+ * Convert a map to fixed point.
+ *
+ * @param map Created map.
+ *
+ * @param map_q15 Uninitialized fixed point map.
+ *
+ * @return Returns 0 on success. -1 if an element or offset is out of range.
+ */
+
+int joystick_map_q15_create(const struct joystick_map * const map, struct joystick_map_q15 * const map_q15);
+
+/*
+ * Same as joystick_map_translate.
+ *
+ * @param output Outputs, INT16_MAX is 1.0.
+ */
+
+void joystick_map_q15_translate(const struct joystick_map_q15 * const map_q15, const struct joystick_input_value_q15 *input_value, int16_t * const output, const uint32_t output_length);
+
+/*
+ * Translate from a plain array of input_count axis values.
+ */
+
+void joystick_map_q15_translate_array(const struct joystick_map_q15 * const map_q15, const int16_t *input, int16_t * const output, const uint32_t output_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+/*
+ * Decription:
+ * 	Background thread that reads a joystick device and pushes the
+ * 	timestamped events into a lock-free ring. The application thread
+ * 	drains the ring without system calls or locks.
+ * Notes:
+ *	- While the reader is running the thread owns the device. Do not poll,
+ *	  read, reopen or close the device from other threads.
+ *	- A disconnected device is reopened by the reader thread.
+ *	- Drain must be called from one thread only.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_READER_H_
+#define JOYSTICK_READER_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+#include "joystick.h"
+#include "joystick_ring.h"
+#include "joystick_wait.h"
+
+/* How often the reader thread tries to reopen a disconnected device. */
+#define JOYSTICK_READER_REOPEN_INTERVAL_MS 	1000
+
+
+struct joystick_reader
+{
+	struct joystick_ring reader_ring;
+
+	struct joystick_device *reader_device;
+	struct joystick_wait reader_wait;
+	pthread_t reader_thread;
+
+	/* Set by stop, read by the reader thread. */
+	int reader_stop;
+
+	/* 1 while the device is open, written by the reader thread. */
+	int reader_connected;
+};
+
+
+/*
+ * Start reader thread for an open device.
+ *
+ * @param reader Uninitialized reader.
+ *
+ * @param device Open joystick device. Must outlive the reader.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_reader_start(struct joystick_reader *reader, struct joystick_device *device);
+
+/*
+ * Stop and join the reader thread. The device is left open if it is connected.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_reader_stop(struct joystick_reader *reader);
+
+
+/*
+ * Drain events read by the reader thread. Never blocks.
+ *
+ * @param events Will be filled with the events, in the order they were read.
+ *
+ * @param event_max Maxium elements events fits.
+ *
+ * @return Returns number of events drained.
+ */
+
+size_t joystick_reader_drain(struct joystick_reader *reader, struct js_event *events, size_t event_max);
+
+/*
+ * Drain all pending events and decode them into value, like poll.
+ *
+ * @param value Where decoded data will be stored.
+ *
+ * @return Returns 1 if there are new values, 0 on nothing.
+ */
+
+int joystick_reader_drain_value(struct joystick_reader *reader, struct joystick_input_value *input_value);
+
+
+/*
+ * Check if the reader thread currently have the device open.
+ *
+ * @return Returns 1 if connected, else -1
+ */
+
+int joystick_reader_is_connected(struct joystick_reader *reader);
+
+/*
+ * Number of events lost because the consumer did not drain in time.
+ */
+
+uint32_t joystick_reader_dropped(struct joystick_reader *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Decription:
+ * 	Record the events read from a device to a file, to replay them later
+ * 	through a joystick_source, so programs and benchmarks can run the
+ * 	same input without hardware.
+ * Notes:
+ *	- File format, native byte order:
+ *	  	struct joystick_record_header
+ *	  	struct js_event, appended in the order they were read.
+ *	- The recorder is attached with joystick_device_use_record, every
+ *	  event read by the device is then appended, whichever poll read it.
+ *	- Recordings are replayed with JOYSTICK_SOURCE_REPLAY, see
+ *	  joystick_source.h
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_RECORD_H_
+#define JOYSTICK_RECORD_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+
+/* "JSR1" */
+#define JOYSTICK_RECORD_MAGIC 		0x4a535231
+#define JOYSTICK_RECORD_VERSION 	1
+
+
+struct joystick_record_header
+{
+	uint32_t header_magic;
+	uint32_t header_version;
+
+	uint8_t header_axis_count;
+	uint8_t header_button_count;
+	uint8_t header_reserved[2];
+
+	/* Null terminated. */
+	uint8_t header_name[JOYSTICK_NAME_LENGTH];
+};
+
+struct joystick_record
+{
+	int record_fd;
+
+	/* Set if a write failed, the file is missing events after it. */
+	int record_failed;
+};
+
+
+/*
+ * Create recording file and write the header.
+ *
+ * @param record Uninitialized recorder.
+ *
+ * @param path File to create, replaced if it exists.
+ *
+ * @param input_attrib Attributes of the recorded device.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_record_create(struct joystick_record *record, const char *path, const struct joystick_input_attrib *input_attrib);
+
+/*
+ * Append events.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_record_write(struct joystick_record *record, const struct js_event *events, size_t event_count);
+
+/*
+ * Close recording file.
+ *
+ * @return Returns 0 on success. -1 if any write failed.
+ */
+
+int joystick_record_close(struct joystick_record *record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Decription:
+ * 	Fixed size lock-free ring of joystick events with exactly one
+ * 	producer thread and one consumer thread.
+ * Notes:
+ *	- Push and pop never block and never call into the kernel.
+ *	- Events pushed to a full ring are dropped and counted.
+ *	- Producer and consumer indices are kept on separate cache lines.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_RING_H_
+#define JOYSTICK_RING_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+
+/* Must be a power of two. */
+#define JOYSTICK_RING_SIZE 	1024
+
+
+struct joystick_ring
+{
+	/* Written by producer. */
+	uint32_t ring_head __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+	uint32_t ring_dropped;
+
+	/* Producer copy of ring_tail, refreshed only when the ring looks full. */
+	uint32_t ring_tail_cache;
+
+	/* Written by consumer. */
+	uint32_t ring_tail __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+
+	/* Consumer copy of ring_head, refreshed only when the ring looks empty. */
+	uint32_t ring_head_cache;
+
+	struct js_event ring_event[JOYSTICK_RING_SIZE] __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+};
+
+
+/*
+ * Create empty ring.
+ *
+ * @param ring Uninitialized ring.
+ */
+
+void joystick_ring_create(struct joystick_ring *ring);
+
+/*
+ * Push events. Called from the producer thread only.
+ *
+ * @param events Events to push.
+ *
+ * @param event_count Number of events.
+ *
+ * @return Returns number of events pushed. The rest are dropped.
+ */
+
+size_t joystick_ring_push(struct joystick_ring *ring, const struct js_event *events, size_t event_count);
+
+/*
+ * Pop events in the order they were pushed. Called from the consumer thread only.
+ *
+ * @param events Will be filled with the popped events.
+ *
+ * @param event_max Maxium elements events fits.
+ *
+ * @return Returns number of events popped.
+ */
+
+size_t joystick_ring_pop(struct joystick_ring *ring, struct js_event *events, size_t event_max);
+
+/*
+ * Number of events dropped because the ring was full. Safe to call from any thread.
+ */
+
+uint32_t joystick_ring_dropped(struct joystick_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
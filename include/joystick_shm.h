@@ -0,0 +1,127 @@
+/*
+ * Decription:
+ * 	Mirror the latest input value of a joystick into shared memory, so
+ * 	several processes can read one device that only one process owns.
+ * Notes:
+ *	- The owner creates the region and writes. Any number of processes
+ *	  attach read only and read it without system calls.
+ *	- The region holds the device attributes and a joystick_publish, so
+ *	  readers get the value, the write count and the kernel event time.
+ *	- Named regions use shm_open, e.g. "/joystick0". Without a name the
+ *	  region is an anonymous memfd, its shm_fd can be passed on to other
+ *	  processes by fork or over a unix socket.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_SHM_H_
+#define JOYSTICK_SHM_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stdint.h>
+
+#include <linux/limits.h>
+
+#include "joystick.h"
+#include "joystick_publish.h"
+
+#define JOYSTICK_SHM_MAGIC 	0x4a534d31
+#define JOYSTICK_SHM_VERSION 	1
+
+
+struct joystick_shm_region
+{
+	/* Written last by the owner, once the region is initialized. */
+	uint32_t region_magic;
+	uint32_t region_version;
+	uint32_t region_size;
+
+	struct joystick_input_attrib region_input_attrib;
+	struct joystick_publish region_publish;
+};
+
+struct joystick_shm
+{
+	int shm_fd;
+	int shm_owner;
+	struct joystick_shm_region *shm_region;
+
+	/* Empty for anonymous regions. */
+	char shm_name[NAME_MAX + 1];
+};
+
+
+/*
+ * Create shared region and become its writer. Fails with EEXIST if the
+ * name is taken. A region left behind by a crashed owner has to be removed
+ * with shm_unlink first.
+ *
+ * @param shm Uninitialized shared memory state.
+ *
+ * @param name Name passed to shm_open. NULL creates an anonymous region.
+ *
+ * @param input_attrib Attributes of the published device.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_shm_create(struct joystick_shm *shm, const char *name, const struct joystick_input_attrib *input_attrib);
+
+/*
+ * Attach read only to a named region.
+ *
+ * @param shm Uninitialized shared memory state.
+ *
+ * @param name Name the owner created the region with.
+ *
+ * @return Returns 0 on success. -1 on failure or if the region is not initialized.
+ */
+
+int joystick_shm_attach(struct joystick_shm *shm, const char *name);
+
+/*
+ * Attach read only to a region by file descriptor, etc. an anonymous region.
+ * The file descriptor is duplicated.
+ *
+ * @return Returns 0 on success. -1 on failure or if the region is not initialized.
+ */
+
+int joystick_shm_attach_fd(struct joystick_shm *shm, int fd);
+
+/*
+ * Detach from the region. The owner also removes the name of a named region.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_shm_destroy(struct joystick_shm *shm);
+
+
+/*
+ * Publish new value. Owner only.
+ */
+
+void joystick_shm_write(struct joystick_shm *shm, const struct joystick_input_value *input_value);
+
+/*
+ * Take a consistent copy of the latest value.
+ *
+ * @return Returns the number of writes the copy reflects.
+ */
+
+uint32_t joystick_shm_read(const struct joystick_shm *shm, struct joystick_input_value *input_value);
+
+/*
+ * Attributes of the published device.
+ */
+
+const struct joystick_input_attrib *joystick_shm_input_attrib(const struct joystick_shm *shm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
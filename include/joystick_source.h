@@ -0,0 +1,158 @@
+/*
+ * Decription:
+ * 	Input sources a joystick_device can be opened on: the joydev device,
+ * 	a stream of js_event records written by the program, a generator
+ * 	producing synthetic input at a given rate, or a recording made with
+ * 	joystick_record. Programs, tests and benchmarks can then run without
+ * 	a physical joystick.
+ * Notes:
+ *	- Every source gives the device a file descriptor and real js_event
+ *	  records, so poll, decode, wait, device sets and readers work the
+ *	  same on all of them.
+ *	- Stream, generator and replay devices are the read end of a pipe.
+ *	  Events are written at most PIPE_BUF at a time so a read never sees
+ *	  half an event. Generator and replay share one writer thread.
+ *	- The generator first writes INIT events for every axis and button, as
+ *	  joydev does on open, then the pattern. Values and event times follow
+ *	  from the config only, so runs are repeatable. Event times count
+ *	  milliseconds at the configured rate, not the wall clock.
+ *	- Replay maps the recording and writes its events with the recorded
+ *	  timing, or as fast as the device is read.
+ *	- When a stream, generator or replay source ends the device reads as
+ *	  disconnected, like an unplugged device.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_SOURCE_H_
+#define JOYSTICK_SOURCE_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pthread.h>
+
+#include "joystick.h"
+
+
+enum joystick_source_type
+{
+	JOYSTICK_SOURCE_JOYDEV = 1,
+	JOYSTICK_SOURCE_STREAM = 2,
+	JOYSTICK_SOURCE_GENERATOR = 3,
+	JOYSTICK_SOURCE_REPLAY = 4,
+};
+
+enum joystick_source_pattern
+{
+	/* Every axis follows a sine, phase shifted per axis, one event per axis per frame. */
+	JOYSTICK_SOURCE_SINE = 1,
+
+	/* Buttons are pressed and released round robin. */
+	JOYSTICK_SOURCE_BUTTON_STORM = 2,
+
+	/* Bursts of random axis and button events with idle time in between. */
+	JOYSTICK_SOURCE_BURST = 3,
+};
+
+struct joystick_source_config
+{
+	enum joystick_source_type config_type;
+
+	/*
+	 * JOYSTICK_SOURCE_JOYDEV: device to open, etc. /dev/input/js0
+	 * JOYSTICK_SOURCE_REPLAY: recording to replay, see joystick_record.h
+	 */
+	const char *config_device_path;
+
+	/* JOYSTICK_SOURCE_REPLAY: non zero to keep the recorded timing, else as fast as the device is read. */
+	int config_realtime;
+
+	/* JOYSTICK_SOURCE_STREAM and JOYSTICK_SOURCE_GENERATOR: attributes the device reports. */
+	struct joystick_input_attrib config_input_attrib;
+
+	/* JOYSTICK_SOURCE_GENERATOR only. */
+	enum joystick_source_pattern config_pattern;
+
+	/* Events per second, within a burst for bursts. 0 for as fast as the device is read. */
+	uint32_t config_rate;
+
+	/* Sine period, not 0, or idle time between bursts, in milliseconds of event time. */
+	uint32_t config_period_ms;
+
+	/* Events per burst. */
+	uint32_t config_burst;
+
+	/* Events after the INIT events, 0 for no end. */
+	uint64_t config_event_count;
+
+	uint32_t config_seed;
+};
+
+struct joystick_source
+{
+	enum joystick_source_type source_type;
+
+	pthread_t source_thread;
+
+	/* Write end of the pipe, -1 for joydev. */
+	int source_fd;
+
+	/* Wakes the writer thread to stop. */
+	int source_stop_fd;
+
+	struct joystick_source_config source_config;
+
+	/* Mapped recording, NULL unless replay. */
+	const uint8_t *source_replay;
+	size_t source_replay_size;
+};
+
+
+/*
+ * Fill config with the defaults of a source type. Stream and generator
+ * sources report 6 axes and 17 buttons, the generator plays a 1 Hz sine
+ * at 1000 events per second without end.
+ */
+
+void joystick_source_config_default(struct joystick_source_config *config, enum joystick_source_type type);
+
+/*
+ * Open device on a source.
+ *
+ * @param source Uninitialized source.
+ *
+ * @param device Uninitialized device. Close it with joystick_device_close as usual.
+ *
+ * @param config Source to open.
+ *
+ * @return Returns 0 on success. -1 on failure or if a replayed file is not a recording.
+ */
+
+int joystick_source_open(struct joystick_source *source, struct joystick_device *device, const struct joystick_source_config *config);
+
+/*
+ * Write events to a stream source. Blocks while the pipe is full.
+ *
+ * @return Returns 0 on success. -1 on failure or if the device is closed.
+ */
+
+int joystick_source_write(struct joystick_source *source, const struct js_event *events, size_t event_count);
+
+/*
+ * Stop the source and unmap a replayed recording. The device reads as
+ * disconnected once the written events are read, and stays open until
+ * closed.
+ */
+
+void joystick_source_close(struct joystick_source *source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
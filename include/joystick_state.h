@@ -0,0 +1,122 @@
+/*
+ * Decription:
+ * 	Compact input state for copying, publishing and comparing. Raw int16
+ * 	axes, buttons as a bitmask, a sequence number and the event time in
+ * 	two cache lines, against 200 bytes for joystick_input_value.
+ * Notes:
+ *	- The header and the first 24 axes share the first cache line.
+ *	- Axes are raw event values, INT16_MAX is 1.0, like joystick_q15.
+ *	- Only state_axis_count axes and state_button_count buttons are used,
+ *	  the rest are kept zero so states can be compared with memcmp.
+ *	- Holds the first JOYSTICK_AXIS_MAX axes and JOYSTICK_BUTTON_MAX
+ *	  buttons of larger devices.
+ *	- The sequence is incremented every time the state gets new values.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_STATE_H_
+#define JOYSTICK_STATE_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "joystick.h"
+#include "joystick_q15.h"
+
+
+struct joystick_state
+{
+	uint32_t state_sequence;
+
+	/* Kernel time in milliseconds of the last event. */
+	uint32_t state_event_time;
+
+	/* Bit n is button n. */
+	uint32_t state_button;
+
+	uint8_t state_axis_count;
+	uint8_t state_button_count;
+
+	int16_t state_axis[JOYSTICK_AXIS_MAX];
+} __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+
+
+/*
+ * Create zeroed state for a device. Holds the first JOYSTICK_AXIS_MAX
+ * axes and JOYSTICK_BUTTON_MAX buttons of wider devices.
+ *
+ * @param state Uninitialized state.
+ *
+ * @param input_attrib Attributes of the device, for the axis and button count.
+ */
+
+void joystick_state_create(struct joystick_state *state, const struct joystick_input_attrib *input_attrib);
+
+/*
+ * Same as joystick_device_poll, but into compact state.
+ *
+ * @return Returns 1 if there are new values, 0 on nothing, but success. -1 on failure.
+ */
+
+int joystick_device_poll_state(struct joystick_device *device, struct joystick_state *state);
+
+/*
+ * Same as joystick_device_decode, but into compact state. Does not
+ * change the sequence.
+ */
+
+void joystick_device_decode_state(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_state *state);
+
+
+/*
+ * Convert from input value. Axes are rounded and clamped, buttons
+ * are pressed if non zero. Increments the sequence.
+ */
+
+void joystick_state_from_value(struct joystick_state *state, const struct joystick_input_value *input_value);
+
+/*
+ * Convert to input value. Unused axes and buttons are zeroed.
+ */
+
+void joystick_state_to_value(const struct joystick_state *state, struct joystick_input_value *input_value);
+
+/*
+ * Convert from integer input value. Increments the sequence.
+ */
+
+void joystick_state_from_value_q15(struct joystick_state *state, const struct joystick_input_value_q15 *input_value);
+
+/*
+ * Convert to integer input value. Unused axes and buttons are zeroed.
+ */
+
+void joystick_state_to_value_q15(const struct joystick_state *state, struct joystick_input_value_q15 *input_value);
+
+
+/*
+ * Compare axes and buttons, ignoring sequence and time.
+ *
+ * @return Returns 1 if equal, else -1.
+ */
+
+int joystick_state_is_equal(const struct joystick_state *a, const struct joystick_state *b);
+
+/*
+ * Get axes that differ.
+ *
+ * @return Bit n is set if axis n differs.
+ */
+
+uint32_t joystick_state_axis_changed(const struct joystick_state *a, const struct joystick_state *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
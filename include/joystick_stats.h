@@ -0,0 +1,168 @@
+/*
+ * Decription:
+ * 	Counters and histograms of how a device is read: read calls, empty
+ * 	reads, events and bytes per read, time from the kernel timestamp of
+ * 	an event until it is read, disconnects and time disconnected.
+ * Notes:
+ *	- Only updated when the library is built with JOYSTICK_STATS defined,
+ *	  cmake -DJOYSTICK_STATS=ON. Without it the updates are not compiled
+ *	  and the read path is unchanged.
+ *	- One thread updates the counters, the one reading the device. Any
+ *	  thread can take a snapshot, protected by a sequence lock as in
+ *	  joystick_publish.h.
+ *	- Latency buckets are logarithmic with 4 buckets per power of two,
+ *	  so a bucket is within 25% of its values.
+ *	- joydev event times are milliseconds on a kernel clock with an
+ *	  unknown offset. Their latency is measured from the fastest delivery
+ *	  seen, with millisecond resolution. When a faster delivery is seen,
+ *	  the latencies counted so far are moved by the difference, so the
+ *	  histogram is always relative to the fastest delivery. Latencies up
+ *	  to JOYSTICK_STATS_JOYDEV_RANGE milliseconds are moved exactly, those
+ *	  above keep their earlier baseline. evdev event times are taken as
+ *	  CLOCK_MONOTONIC and measured exactly.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_STATS_H_
+#define JOYSTICK_STATS_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <linux/input.h>
+
+#include "joystick.h"
+
+/* Events per non empty read, bucket n counts reads of 2^n to 2^(n+1)-1 events. */
+#define JOYSTICK_STATS_READ_BUCKETS 	8
+
+/* Latency in microseconds up to about 15 s, the last bucket also holds everything above. */
+#define JOYSTICK_STATS_LATENCY_BUCKETS 	92
+
+/* joydev latencies kept per millisecond, to move them when the fastest delivery changes. */
+#define JOYSTICK_STATS_JOYDEV_RANGE 	1024
+
+
+struct joystick_stats_value
+{
+	/* read() calls, and those that returned no events. */
+	uint64_t value_read_count;
+	uint64_t value_empty_count;
+
+	uint64_t value_event_count;
+	uint64_t value_byte_count;
+
+	uint64_t value_disconnect_count;
+	uint64_t value_reconnect_count;
+
+	/* Time spent disconnected before the last reconnect. */
+	uint64_t value_disconnected_ns;
+
+	/* CLOCK_MONOTONIC time of the disconnect, 0 while connected. */
+	uint64_t value_disconnect_time;
+
+	uint64_t value_read_events[JOYSTICK_STATS_READ_BUCKETS];
+	uint64_t value_latency[JOYSTICK_STATS_LATENCY_BUCKETS];
+};
+
+struct joystick_stats
+{
+	/* Odd while an update is in progress. */
+	uint32_t stats_sequence __attribute__((aligned(JOYSTICK_CACHE_LINE_SIZE)));
+
+	/* Lowest difference seen between the read time and a joydev event time, in milliseconds. */
+	uint32_t stats_joydev_offset;
+	int stats_joydev_calibrated;
+
+	/* Events per joydev latency in milliseconds, only used by the updating thread. */
+	uint64_t stats_joydev_latency[JOYSTICK_STATS_JOYDEV_RANGE];
+
+	struct joystick_stats_value stats_value;
+};
+
+
+/*
+ * Non zero if the library is built with JOYSTICK_STATS.
+ */
+
+int joystick_stats_enabled(void);
+
+/*
+ * Create zeroed stats.
+ *
+ * @param stats Uninitialized stats.
+ */
+
+void joystick_stats_create(struct joystick_stats *stats);
+
+/*
+ * Copy a consistent snapshot, without blocking the updating thread.
+ *
+ * @param value Will be filled with the counters.
+ */
+
+void joystick_stats_snapshot(const struct joystick_stats *stats, struct joystick_stats_value *value);
+
+/*
+ * Collect stats of the device while it is read. The stats must not
+ * be shared with other devices.
+ *
+ * @param stats Created stats, or NULL for none.
+ *
+ * @return Returns 0 on success. -1 if the library is built without JOYSTICK_STATS.
+ */
+
+int joystick_device_use_stats(struct joystick_device *device, struct joystick_stats *stats);
+
+
+/*
+ * Latency bucket of a value in microseconds.
+ */
+
+uint32_t joystick_stats_bucket(uint64_t latency_us);
+
+/*
+ * Smallest latency in microseconds counted by a bucket.
+ */
+
+uint64_t joystick_stats_bucket_lower(uint32_t bucket);
+
+/*
+ * Latency percentile from a snapshot.
+ *
+ * @param percentile Between 0 and 1, etc. 0.99.
+ *
+ * @return Returns the lower bound in microseconds of the bucket holding the percentile, 0 if nothing is counted.
+ */
+
+uint64_t joystick_stats_percentile(const struct joystick_stats_value *value, double percentile);
+
+
+/*
+ * Updates made by the library when built with JOYSTICK_STATS.
+ */
+
+/*
+ * A read of the device.
+ *
+ * @param byte_count Bytes read, 0 if nothing was read.
+ */
+
+void joystick_stats_read(struct joystick_stats *stats, size_t byte_count, const struct js_event *events, size_t event_count);
+
+void joystick_stats_read_evdev(struct joystick_stats *stats, size_t byte_count, const struct input_event *events, size_t event_count);
+
+void joystick_stats_disconnect(struct joystick_stats *stats);
+
+void joystick_stats_reconnect(struct joystick_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Decription:
+ * 	Identify joystick devices from sysfs without opening the device nodes.
+ * Notes:
+ *	- Name and capabilities are read from <sysfs_path>/jsN/device/. Axis and
+ *	  button counts are derived from the capability bitmaps the same way the
+ *	  joydev driver counts them.
+ *	- Only devices that satisfy the requirement are checked for read access.
+ *	  If the sysfs entry of a device can not be read, the device node is
+ *	  opened and queried with ioctl instead.
+ *	- Bitmap words are assumed to be as wide as long in the current process.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_SYSFS_H_
+#define JOYSTICK_SYSFS_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+
+#include "joystick.h"
+
+#define JOYSTICK_SYSFS_PATH 	"/sys/class/input/"
+#define JOYSTICK_SYSFS_DEV_PATH 	"/dev/input/"
+
+
+/*
+ * Read attributes of joystick jsN from sysfs.
+ *
+ * @param sysfs_path Directory with the jsN entries. NULL for /sys/class/input/
+ *
+ * @param dev_path Directory with the jsN device nodes. NULL for /dev/input/
+ *
+ * @param name Name of the joystick, etc. js0.
+ *
+ * @param input_attrib will be filled with the results.
+ *
+ * @return Returns 0 on success. -1 if the sysfs entry can not be read.
+ */
+
+int joystick_sysfs_attrib(const char *sysfs_path, const char *dev_path, const char *name, struct joystick_input_attrib *input_attrib);
+
+
+/*
+ * Same as joystick_device_identify_by_requirement, but the attributes are read
+ * from sysfs and only matching device nodes are touched.
+ *
+ * @param sysfs_path Directory with the jsN entries. NULL for /sys/class/input/
+ *
+ * @param dev_path Directory with the jsN device nodes. NULL for /dev/input/
+ *
+ * @return returns 0 if no devices are found. Otherwise number of devices found.
+ */
+
+size_t joystick_sysfs_identify_by_requirement(const char *sysfs_path, const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Decription:
+ * 	Block until joystick devices or other file descriptors are readable,
+ * 	instead of spinning on joystick_device_poll.
+ * Notes:
+ *	- Built on epoll. Every registered file descriptor carries a tag that is
+ *	  handed back when it is ready.
+ *	- wait_event_fd is an eventfd that is always registered. Use wakeup to
+ *	  interrupt a blocked wait from another thread.
+ *	- A reopened device gets a new file descriptor and has to be added again.
+ *	  A closed file descriptor is removed from the wait set by the kernel.
+ * Error:
+ * 	Assert on logical error.
+ */
+
+#ifndef JOYSTICK_WAIT_H_
+#define JOYSTICK_WAIT_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <time.h>
+
+#include "joystick.h"
+
+/* Maxium number of ready file descriptors reported by one wait. */
+#define JOYSTICK_WAIT_EVENT_MAX 	64
+
+/* Tag reported when the wait was interrupted by wakeup. */
+#define JOYSTICK_WAIT_TAG_WAKEUP 	UINT64_MAX
+
+
+struct joystick_wait
+{
+	int wait_epoll_fd;
+	int wait_event_fd;
+};
+
+
+/*
+ * Create wait set.
+ *
+ * @param wait Uninitialized wait set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_create(struct joystick_wait *wait);
+
+/*
+ * Destroy wait set. Registered file descriptors are not closed.
+ *
+ * @param wait Initialized wait set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_destroy(struct joystick_wait *wait);
+
+
+/*
+ * Add file descriptor to the wait set. Waits for it to be readable.
+ *
+ * @param wait Initialized wait set.
+ *
+ * @param fd File descriptor to wait on.
+ *
+ * @param tag Returned by poll when fd is readable. Must not be JOYSTICK_WAIT_TAG_WAKEUP.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_add(struct joystick_wait *wait, int fd, uint64_t tag);
+
+/*
+ * Remove file descriptor from the wait set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_remove(struct joystick_wait *wait, int fd);
+
+
+/*
+ * Add open joystick device to the wait set.
+ *
+ * @param device Open joystick device.
+ *
+ * @param tag Returned by poll when device has events.
+ *
+ * @return Returns 0 on success. -1 on failure or if the device is closed.
+ */
+
+int joystick_wait_add_device(struct joystick_wait *wait, struct joystick_device *device, uint64_t tag);
+
+/*
+ * Remove open joystick device from the wait set.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_remove_device(struct joystick_wait *wait, struct joystick_device *device);
+
+
+/*
+ * Interrupt a blocked poll. Safe to call from any thread.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+
+int joystick_wait_wakeup(struct joystick_wait *wait);
+
+
+/*
+ * Block until any registered file descriptor is readable, wakeup is called
+ * or the timeout expires.
+ *
+ * @param wait Initialized wait set.
+ *
+ * @param tags Will be filled with the tags of the ready file descriptors.
+ *
+ * @param tag_max Maxium elements tags fits.
+ *
+ * @param timeout_ms Timeout in milliseconds. -1 blocks forever, 0 returns at once.
+ *
+ * @return Returns number of tags written, 0 on timeout or signal. -1 on failure.
+ */
+
+int joystick_wait_poll(struct joystick_wait *wait, uint64_t *tags, size_t tag_max, int timeout_ms);
+
+/*
+ * Same as poll, but blocks until an absolute CLOCK_MONOTONIC deadline.
+ * A signal does not end the wait, it goes on for the time left.
+ *
+ * @param deadline Absolute time. NULL blocks forever.
+ *
+ * @return Returns number of tags written, 0 when the deadline has passed. -1 on failure.
+ */
+
+int joystick_wait_poll_until(struct joystick_wait *wait, uint64_t *tags, size_t tag_max, const struct timespec *deadline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -16,9 +16,10 @@
 #include <pthread.h>
 
 #include "joystick.h"
-
-
-#define JOYSTICK_EVENT_BUFFER_SIZE 128
+#include "joystick_curve.h"
+#include "joystick_filter.h"
+#include "joystick_record.h"
+#include "joystick_stats.h"
 
 
 
@@ -62,63 +63,178 @@ int joystick_device_is_open(struct joystick_device *device)
 	return device->device_fd <= 0 ? -1 : 1;
 }
 
-int joystick_device_poll(struct joystick_device *device, struct joystick_input_value *input_value)
+int joystick_device_read(struct joystick_device *device, struct js_event *events, size_t event_max)
 {
 	assert(device != NULL);
-	assert(input_value != NULL);
+	assert(events != NULL);
+	assert(event_max > 0);
+
+	ssize_t bytes_read = read(device->device_fd, events, event_max*sizeof(struct js_event));
+	if(bytes_read < 0){
+		if(errno == EAGAIN){
+#ifdef JOYSTICK_STATS
+			if(device->device_stats != NULL){
+				joystick_stats_read(device->device_stats, 0, events, 0);
+			}
+#endif
+			return 0;
+		}
 
-	
-	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
-	ssize_t bytes_read = read(device->device_fd, js_event_buffer, sizeof js_event_buffer);
-	if((bytes_read < 0)  && (errno != EAGAIN)){
 		close(device->device_fd);
 		device->device_fd = -1;
+#ifdef JOYSTICK_STATS
+		if(device->device_stats != NULL){
+			joystick_stats_disconnect(device->device_stats);
+		}
+#endif
 		return -1;	
 	}
+
+	/* End of file, the device is gone or a replay ended. */
+	if(bytes_read == 0){
+		close(device->device_fd);
+		device->device_fd = -1;
+#ifdef JOYSTICK_STATS
+		if(device->device_stats != NULL){
+			joystick_stats_disconnect(device->device_stats);
+		}
+#endif
+		return -1;
+	}
 	
-	const uint32_t buffer_size_verify = ((size_t)bytes_read)%sizeof(struct js_event); 
-	if(buffer_size_verify == 0)
+	const size_t buffer_size_verify = ((size_t)bytes_read)%sizeof(struct js_event); 
+	if(buffer_size_verify != 0)
 	{
+		return 0;
+	}
 
-		const size_t buffer_size = ((size_t)bytes_read)/sizeof(struct js_event); 
+	const size_t event_count = ((size_t)bytes_read)/sizeof(struct js_event);
 
-		const int16_t joystick_axis_count = device->input_attrib.joystick_axis_count;
-		const int16_t joystick_button_count = device->input_attrib.joystick_button_count;
+#ifdef JOYSTICK_STATS
+	if(device->device_stats != NULL){
+		joystick_stats_read(device->device_stats, (size_t)bytes_read, events, event_count);
+	}
+#endif
 
-		for(size_t i = 0; i < buffer_size; i++)
-		{
-			/*
-			 * Read event and write to input buffer
-			 */
+	if(device->device_record != NULL){
+		joystick_record_write(device->device_record, events, event_count);
+	}
 
-			__u8 number = js_event_buffer[i].number;
-			__s16 value = js_event_buffer[i].value;
+	return (int)event_count;
+}
 
-			switch(js_event_buffer[i].type & ~JS_EVENT_INIT)
-			{
+void joystick_input_value_clear_changed(struct joystick_input_value *input_value)
+{
+	assert(input_value != NULL);
+
+	input_value->joystick_axis_changed = 0;
+	input_value->joystick_button_pressed = 0;
+	input_value->joystick_button_released = 0;
+	input_value->joystick_button_changed = 0;
+}
+
+void joystick_device_use_curve(struct joystick_device *device, const struct joystick_curve *curve)
+{
+	assert(device != NULL);
+
+	device->device_curve = curve;
+}
+
+void joystick_device_use_filter(struct joystick_device *device, struct joystick_filter *filter)
+{
+	assert(device != NULL);
+
+	device->device_filter = filter;
+}
+
+void joystick_device_use_record(struct joystick_device *device, struct joystick_record *record)
+{
+	assert(device != NULL);
+
+	device->device_record = record;
+}
+
+void joystick_device_decode(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_value *input_value)
+{
+	assert(device != NULL);
+	assert(events != NULL);
+	assert(input_value != NULL);
+
+	/* Larger devices are only decoded in part. */
+	const int16_t joystick_axis_count = device->input_attrib.joystick_axis_count < JOYSTICK_AXIS_MAX ? device->input_attrib.joystick_axis_count : JOYSTICK_AXIS_MAX;
+	const int16_t joystick_button_count = device->input_attrib.joystick_button_count < JOYSTICK_BUTTON_MAX ? device->input_attrib.joystick_button_count : JOYSTICK_BUTTON_MAX;
+	const struct joystick_curve *curve = device->device_curve;
+	struct joystick_filter *filter = device->device_filter;
 
+	for(size_t i = 0; i < event_count; i++)
+	{
+		/*
+		 * Read event and write to input buffer
+		 */
 
-				case JS_EVENT_AXIS:
-					if(number < joystick_axis_count){
-						/* Map INT16_T range to float [-1, 1] */
-						float mapped = ((float)value)/((float)INT16_MAX);
-						input_value->joystick_axis_value[number] = mapped;
+		__u8 number = events[i].number;
+		__s16 value = events[i].value;
+
+		switch(events[i].type & ~JS_EVENT_INIT)
+		{
+
+
+			case JS_EVENT_AXIS:
+				if(number < joystick_axis_count){
+					/* Map INT16_T range to float [-1, 1] */
+					float mapped = curve != NULL ? joystick_curve_apply(curve, number, value) : ((float)value)/((float)INT16_MAX);
+
+					if(filter != NULL){
+						mapped = events[i].type & JS_EVENT_INIT ? joystick_filter_start(filter, number, mapped, events[i].time) : joystick_filter_apply(filter, number, mapped, events[i].time);
 					}
-				break;	
 
-				case JS_EVENT_BUTTON:
-					if(number < joystick_button_count){
-						input_value->joystick_button_value[number] = value;
+					input_value->joystick_axis_value[number] = mapped;
+					input_value->joystick_axis_changed |= 1u << number;
+					input_value->joystick_event_time = events[i].time;
+				}
+			break;	
+
+			case JS_EVENT_BUTTON:
+				if(number < joystick_button_count){
+					const uint32_t bit = 1u << number;
+
+					/* INIT events report the state, not a press or release. */
+					if(!(events[i].type & JS_EVENT_INIT) && (value != 0) != (input_value->joystick_button_value[number] != 0)){
+						if(value != 0){
+							input_value->joystick_button_pressed |= bit;
+						}
+						else{
+							input_value->joystick_button_released |= bit;
+						}
+
+						input_value->joystick_button_changed |= bit;
 					}
-				break;	
-			}
 
+					input_value->joystick_button_value[number] = value;
+					input_value->joystick_event_time = events[i].time;
+				}
+			break;	
 		}
 
-		return 1;
 	}
+}
 
-	return 0;
+int joystick_device_poll(struct joystick_device *device, struct joystick_input_value *input_value)
+{
+	assert(device != NULL);
+	assert(input_value != NULL);
+
+	
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	int event_count = joystick_device_read(device, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE);
+	if(event_count <= 0){
+		return event_count;
+	}
+
+	joystick_input_value_clear_changed(input_value);
+	joystick_device_decode(device, js_event_buffer, (size_t)event_count, input_value);
+
+	return 1;
 }
 
 static int joystick_open(const char *device_path, struct joystick_input_attrib *input_attrib)
@@ -152,12 +268,7 @@ static int joystick_open(const char *device_path, struct joystick_input_attrib *
 	}
 
 
-	if(axis_count > JOYSTICK_AXIS_MAX)
-	{
-		goto exit;
-	}
-
-	if(button_count > JOYSTICK_BUTTON_MAX)
+	if(axis_count > JOYSTICK_DEVICE_AXIS_MAX)
 	{
 		goto exit;
 	}
@@ -202,7 +313,8 @@ joystick_device_reopen(struct joystick_device *device)
 	struct joystick_input_attrib input_attrib;
 	memset(&input_attrib, 0, sizeof(input_attrib));
 
-	device->device_fd = joystick_open((const char *)device_path, &input_attrib);
+	const struct joystick_device_opener *opener = device->device_opener;
+	device->device_fd = opener != NULL ? opener->opener_function((const char *)device_path, &input_attrib, opener->opener_arg) : joystick_open((const char *)device_path, &input_attrib);
 	if(device->device_fd < 0){
 		return -1;
 	}
@@ -224,32 +336,94 @@ joystick_device_reopen(struct joystick_device *device)
 		return -1;	
 	}
 
+#ifdef JOYSTICK_STATS
+	if(device->device_stats != NULL){
+		joystick_stats_reconnect(device->device_stats);
+	}
+#endif
 
 	return 1;
 }
 
 
-size_t joystick_device_identify_by_requirement(struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
+int joystick_input_requirement_satisfied(const struct joystick_input_requirement *input_requirement, const struct joystick_input_attrib *input_attrib)
 {
-
 	assert(input_requirement != NULL);
 	assert(input_attrib != NULL);
-	assert(input_attrib_max > 0);
 
-	/* 
-	 * Increase for every joystick that fits requirements.
-	 * Is less than input_attrib_max
-	 */	
+	if(input_requirement->requirement_axis_count_min > input_attrib->joystick_axis_count)
+	{
+		return -1;	
+	}
 
-	size_t joystick_device_found_index = 0;
+	if(input_requirement->requirement_axis_count_max < input_attrib->joystick_axis_count)
+	{
+		return -1;	
+	}
+
+
+	if(input_requirement->requirement_button_count_min > input_attrib->joystick_button_count)
+	{
+		return -1;	
+	}
+
+	if(input_requirement->requirement_button_count_max < input_attrib->joystick_button_count)
+	{
+		return -1;	
+	}
+
+	return 1;
+}
+
+int joystick_device_probe(const char *device_path, struct joystick_input_attrib *input_attrib)
+{
+	assert(device_path != NULL);
+	assert(input_attrib != NULL);
+
+	int device_fd = joystick_open(device_path, input_attrib);
+	if(device_fd < 0){
+		return -1;
+	}
+
+	close(device_fd);
+	return 0;
+}
+
+/*
+ * Order jsN nodes by number, js2 before js10.
+ */
+static int joystick_identify_compare(const void *a, const void *b)
+{
+	const char *path_a = (const char *)a;
+	const char *path_b = (const char *)b;
+
+	size_t length_a = strlen(path_a);
+	size_t length_b = strlen(path_b);
+
+	if(length_a != length_b){
+		return length_a < length_b ? -1 : 1;
+	}
+
+	return strcmp(path_a, path_b);
+}
+
+/*
+ * Collect full paths of all candidate joystick nodes in a directory, 
+ * sorted so every identify function reports devices in the same order. 
+ *
+ * @param candidate Will point to allocated array of paths. Free with free().
+ *
+ * @return Returns number of candidates. 
+ */
+static size_t joystick_identify_candidates(const char *dev_path, char (**candidate)[PATH_MAX])
+{
+	*candidate = NULL;
 
-	
 	/* 
 	 * Open directroy with joystick devices. 
 	 */
 
 	struct dirent *dirent = NULL;
-	const char *dev_path = "/dev/input/";
 
 	
 	DIR *dir = opendir(dev_path);
@@ -265,13 +439,25 @@ size_t joystick_device_identify_by_requirement(struct joystick_input_requirement
 	 */
 	char full_file_path[PATH_MAX];
 	size_t dev_path_length = strlen(dev_path);
+	if(dev_path_length + 1 >= PATH_MAX){
+		closedir(dir);
+		return 0;
+	}
+
 	memcpy(full_file_path, dev_path, dev_path_length);
-		
 
+	/* Allow directory without trailing separator. */
+	if(dev_path_length == 0 || full_file_path[dev_path_length - 1] != '/'){
+		full_file_path[dev_path_length] = '/';
+		dev_path_length = dev_path_length + 1;
+	}
+		
+	size_t candidate_count = 0;
+	size_t candidate_max = 0;
 
 	/* 
 	 *	Iterate over all filenames in the folder
-	 *	and try to open them as joystick devices. 	
+	 *	and keep the ones that may be joystick devices. 	
 	 */
 	while((dirent = readdir(dir)) != NULL)
 	{
@@ -296,91 +482,371 @@ size_t joystick_device_identify_by_requirement(struct joystick_input_requirement
 		size_t filename_length = strlen(filename);
 		size_t filename_last_index = filename_length + dev_path_length;
 
+		if(filename_last_index >= PATH_MAX)
+		{
+			continue;
+		}
+
+		if(candidate_count == candidate_max)
+		{
+			size_t grown_max = candidate_max == 0 ? 16 : candidate_max*2;
+			char (*grown)[PATH_MAX] = realloc(*candidate, grown_max*PATH_MAX);
+			if(grown == NULL){
+				break;
+			}
+
+			*candidate = grown;
+			candidate_max = grown_max;
+		}
+
+		memcpy((*candidate)[candidate_count], full_file_path, dev_path_length);
+		memcpy((*candidate)[candidate_count] + dev_path_length, filename, filename_length + 1);
+		candidate_count = candidate_count + 1;
+	}
+
+	closedir(dir);
+
+	if(candidate_count > 0){
+		qsort(*candidate, candidate_count, PATH_MAX, joystick_identify_compare);
+	}
+
+	return candidate_count;
+}
+
+size_t joystick_device_identify_path(const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
+{
+
+	assert(dev_path != NULL);
+	assert(input_requirement != NULL);
+	assert(input_attrib != NULL);
+	assert(input_attrib_max > 0);
+
+	/* 
+	 * Increase for every joystick that fits requirements.
+	 * Is less than input_attrib_max
+	 */	
+
+	size_t joystick_device_found_index = 0;
+
+	char (*candidate)[PATH_MAX] = NULL;
+	size_t candidate_count = joystick_identify_candidates(dev_path, &candidate);
+
+	/* 
+	 *	Try to open every candidate as joystick device. 	
+	 */
+	for(size_t i = 0; i < candidate_count; i++)
+	{
+		struct joystick_input_attrib curr_input_attrib;
+		if(joystick_device_probe(candidate[i], &curr_input_attrib) < 0)
+		{
+			/* Not a joystick device */	
+			continue;
+		}
+
+		/* 
+		 * If it matches the requirements 
+		 */
+		
+		if(joystick_input_requirement_satisfied(input_requirement, &curr_input_attrib) < 0)
+		{
+			continue;	
+		}
+
+		/* 
+		 * Copy found attributes. 
+		 */		
+		memcpy(&input_attrib[joystick_device_found_index], &curr_input_attrib, sizeof(curr_input_attrib));
+		
+		/* 
+		 * Quit if the array is full. 
+		 */
+		joystick_device_found_index = joystick_device_found_index + 1;
+
+		if(joystick_device_found_index == input_attrib_max){
+			break;	
+		}
+	}
+
+	free(candidate);
+	return joystick_device_found_index;
+}
+
+enum joystick_probe_state
+{
+	JOYSTICK_PROBE_WAITING = 0,
+	JOYSTICK_PROBE_STARTED = 1,
+	JOYSTICK_PROBE_DONE = 2,
+};
+
+struct joystick_probe_slot
+{
+	enum joystick_probe_state slot_state;
+	int slot_result;
+	struct timespec slot_start;
+	struct joystick_input_attrib slot_input_attrib;
+};
+
+/*
+ * Shared by the caller and the workers. Workers that hang in a probe 
+ * are abandoned, so the context is freed by whoever leaves it last. 
+ */
+struct joystick_probe_context
+{
+	pthread_mutex_t probe_mutex;
+	pthread_cond_t probe_cond;
+
+	size_t probe_reference_count;
+	int probe_abandoned;
 
-		if(filename_last_index < PATH_MAX)
+	size_t probe_candidate_next;
+	size_t probe_candidate_count;
+	char (*probe_candidate)[PATH_MAX];
+	struct joystick_probe_slot *probe_slot;
+};
+
+static void joystick_probe_release(struct joystick_probe_context *context)
+{
+	pthread_mutex_lock(&context->probe_mutex);
+	context->probe_reference_count = context->probe_reference_count - 1;
+	const size_t reference_count = context->probe_reference_count;
+	pthread_mutex_unlock(&context->probe_mutex);
+
+	if(reference_count == 0)
+	{
+		pthread_cond_destroy(&context->probe_cond);
+		pthread_mutex_destroy(&context->probe_mutex);
+		free(context->probe_candidate);
+		free(context->probe_slot);
+		free(context);
+	}
+}
+
+static void *joystick_probe_worker(void *arg)
+{
+	struct joystick_probe_context *context = (struct joystick_probe_context *)arg;
+
+	pthread_mutex_lock(&context->probe_mutex);
+
+	while(!context->probe_abandoned && context->probe_candidate_next < context->probe_candidate_count)
+	{
+		const size_t index = context->probe_candidate_next;
+		context->probe_candidate_next = index + 1;
+
+		struct joystick_probe_slot *slot = &context->probe_slot[index];
+		slot->slot_state = JOYSTICK_PROBE_STARTED;
+		clock_gettime(CLOCK_MONOTONIC, &slot->slot_start);
+
+		pthread_mutex_unlock(&context->probe_mutex);
+
+		struct joystick_input_attrib curr_input_attrib;
+		memset(&curr_input_attrib, 0, sizeof curr_input_attrib);
+		int result = joystick_device_probe(context->probe_candidate[index], &curr_input_attrib);
+
+		pthread_mutex_lock(&context->probe_mutex);
+
+		slot->slot_result = result;
+		memcpy(&slot->slot_input_attrib, &curr_input_attrib, sizeof curr_input_attrib);
+		slot->slot_state = JOYSTICK_PROBE_DONE;
+
+		pthread_cond_signal(&context->probe_cond);
+	}
+
+	pthread_mutex_unlock(&context->probe_mutex);
+
+	joystick_probe_release(context);
+	return NULL;
+}
+
+static int64_t joystick_probe_elapsed_ms(const struct timespec *from, const struct timespec *to)
+{
+	return ((int64_t)to->tv_sec - (int64_t)from->tv_sec)*1000 + ((int64_t)to->tv_nsec - (int64_t)from->tv_nsec)/1000000;
+}
+
+/*
+ * Check if the caller can stop waiting. 
+ *
+ * @param wakeup Set to the time when the next started probe times out. 
+ *
+ * @return Returns 1 when every probe is done or given up on. 
+ */
+static int joystick_probe_finished(struct joystick_probe_context *context, size_t worker_count, int timeout_ms, struct timespec *wakeup)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	size_t hung_count = 0;
+	size_t pending_count = 0;
+	int64_t wait_ms = -1;
+
+	for(size_t i = 0; i < context->probe_candidate_count; i++)
+	{
+		const struct joystick_probe_slot *slot = &context->probe_slot[i];
+
+		if(slot->slot_state == JOYSTICK_PROBE_WAITING)
+		{
+			pending_count = pending_count + 1;
+		}
+		else if(slot->slot_state == JOYSTICK_PROBE_STARTED)
 		{
-			
-			/* Note that full_file_path is pointer, */
-			char *full_file_path_filename_offset = (char *)full_file_path + dev_path_length;
-			memcpy(full_file_path_filename_offset, dirent->d_name, filename_length);
-			
-					
-			struct joystick_input_attrib curr_input_attrib;
-			int joystick_device_fd = joystick_open(full_file_path, &curr_input_attrib);
-			if(joystick_device_fd < 0)
+			const int64_t remaining_ms = timeout_ms - joystick_probe_elapsed_ms(&slot->slot_start, &now);
+			if(remaining_ms <= 0)
 			{
-				/* Not a joystick device */	
+				hung_count = hung_count + 1;
 			}
 			else
 			{
-				/* 
-				 * Close after opening.
-				 */
-				close(joystick_device_fd);
-
-				/* 
-				 * If it matches the requirements 
-				 */
-				
-				if(input_requirement->requirement_axis_count_min > curr_input_attrib.joystick_axis_count)
-				{
-					continue;	
+				pending_count = pending_count + 1;
+				if(wait_ms < 0 || remaining_ms < wait_ms){
+					wait_ms = remaining_ms;
 				}
+			}
+		}
+	}
 
-				if(input_requirement->requirement_axis_count_max < curr_input_attrib.joystick_axis_count)
-				{
-					continue;	
-				}
+	/* Waiting probes can not start if every worker hangs. */
+	if(pending_count == 0 || hung_count >= worker_count){
+		return 1;
+	}
 
+	if(wait_ms < 0){
+		wait_ms = timeout_ms;
+	}
 
-				if(input_requirement->requirement_button_count_min > curr_input_attrib.joystick_button_count)
-				{
-					continue;	
-				}
+	*wakeup = now;
+	wakeup->tv_sec = wakeup->tv_sec + (time_t)(wait_ms/1000);
+	wakeup->tv_nsec = wakeup->tv_nsec + (long)(wait_ms%1000)*1000000;
+	if(wakeup->tv_nsec >= 1000000000){
+		wakeup->tv_sec = wakeup->tv_sec + 1;
+		wakeup->tv_nsec = wakeup->tv_nsec - 1000000000;
+	}
 
-				if(input_requirement->requirement_button_count_max < curr_input_attrib.joystick_button_count)
-				{
-					continue;	
-				}
+	return 0;
+}
 
+size_t joystick_device_identify_parallel(const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max, size_t worker_count, int timeout_ms)
+{
+	assert(dev_path != NULL);
+	assert(input_requirement != NULL);
+	assert(input_attrib != NULL);
+	assert(input_attrib_max > 0);
+	assert(worker_count > 0);
+	assert(timeout_ms > 0);
 
+	struct joystick_probe_context *context = calloc(1, sizeof(struct joystick_probe_context));
+	if(context == NULL){
+		return 0;
+	}
 
-				{
-					struct joystick_input_attrib *attrib = &input_attrib[joystick_device_found_index];
+	context->probe_candidate_count = joystick_identify_candidates(dev_path, &context->probe_candidate);
+	context->probe_slot = calloc(context->probe_candidate_count + 1, sizeof(struct joystick_probe_slot));
+	if(context->probe_candidate_count == 0 || context->probe_slot == NULL)
+	{
+		free(context->probe_candidate);
+		free(context->probe_slot);
+		free(context);
+		return 0;
+	}
 
-					/* 
-					 * Copy found attributes. 
-					 */		
-					memcpy(attrib, &curr_input_attrib, sizeof(curr_input_attrib));
-					memcpy(attrib->joystick_device_path, full_file_path, PATH_MAX);
-					
-					/* 
-					 * Quit if the array is full. 
-					 */
-					joystick_device_found_index = joystick_device_found_index + 1;
+	pthread_condattr_t cond_attr;
+	pthread_condattr_init(&cond_attr);
+	pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&context->probe_cond, &cond_attr);
+	pthread_condattr_destroy(&cond_attr);
 
-					if(joystick_device_found_index == input_attrib_max){
-						break;	
-					}
-				
-				}
+	pthread_mutex_init(&context->probe_mutex, NULL);
 
-			}
+	if(worker_count > context->probe_candidate_count){
+		worker_count = context->probe_candidate_count;
+	}
+
+	/* 
+	 * Start workers. One reference for the caller and one per worker.
+	 */
+
+	pthread_attr_t thread_attr;
+	pthread_attr_init(&thread_attr);
+	pthread_attr_setdetachstate(&thread_attr, PTHREAD_CREATE_DETACHED);
+
+	pthread_mutex_lock(&context->probe_mutex);
+	context->probe_reference_count = 1;
+
+	size_t worker_started = 0;
+	for(size_t i = 0; i < worker_count; i++)
+	{
+		pthread_t thread;
+		if(pthread_create(&thread, &thread_attr, joystick_probe_worker, context) != 0){
+			break;
 		}
+
+		context->probe_reference_count = context->probe_reference_count + 1;
+		worker_started = worker_started + 1;
 	}
 
-	closedir(dir);
+	pthread_attr_destroy(&thread_attr);
+
+	if(worker_started == 0)
+	{
+		pthread_mutex_unlock(&context->probe_mutex);
+		joystick_probe_release(context);
+		return joystick_device_identify_path(dev_path, input_requirement, input_attrib, input_attrib_max);
+	}
+
+	/* 
+	 * Wait until every candidate is probed or has timed out.
+	 */
+
+	struct timespec wakeup;
+	while(!joystick_probe_finished(context, worker_started, timeout_ms, &wakeup)){
+		pthread_cond_timedwait(&context->probe_cond, &context->probe_mutex, &wakeup);
+	}
+
+	context->probe_abandoned = 1;
+
+	/* 
+	 * Report in candidate order, same as the sequential scan.
+	 */
+
+	size_t joystick_device_found_index = 0;
+
+	for(size_t i = 0; i < context->probe_candidate_count; i++)
+	{
+		const struct joystick_probe_slot *slot = &context->probe_slot[i];
+
+		if(slot->slot_state != JOYSTICK_PROBE_DONE || slot->slot_result < 0){
+			continue;
+		}
+
+		if(joystick_input_requirement_satisfied(input_requirement, &slot->slot_input_attrib) < 0){
+			continue;
+		}
+
+		memcpy(&input_attrib[joystick_device_found_index], &slot->slot_input_attrib, sizeof(struct joystick_input_attrib));
+		joystick_device_found_index = joystick_device_found_index + 1;
+
+		if(joystick_device_found_index == input_attrib_max){
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&context->probe_mutex);
+	joystick_probe_release(context);
+
 	return joystick_device_found_index;
 }
 
+size_t joystick_device_identify_by_requirement(struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
+{
+	return joystick_device_identify_path("/dev/input/", input_requirement, input_attrib, input_attrib_max);
+}
+
 size_t joystick_device_identify(struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
 {
 
 	struct joystick_input_requirement joystick_input_req = {
 		.requirement_axis_count_min = 0,
 		.requirement_button_count_min = 0,
-		.requirement_axis_count_max = JOYSTICK_AXIS_MAX,
-		.requirement_button_count_max = JOYSTICK_BUTTON_MAX,
+		.requirement_axis_count_max = JOYSTICK_DEVICE_AXIS_MAX,
+		.requirement_button_count_max = JOYSTICK_DEVICE_BUTTON_MAX,
 
 	};
 
@@ -390,6 +856,11 @@ size_t joystick_device_identify(struct joystick_input_attrib *input_attrib, size
 
 
 int joystick_device_open(struct joystick_device *device, const char *device_path)
+{
+	return joystick_device_open_with(device, device_path, NULL);
+}
+
+int joystick_device_open_with(struct joystick_device *device, const char *device_path, const struct joystick_device_opener *opener)
 {
 	assert(device != NULL);
 	assert(device_path != NULL);
@@ -398,13 +869,30 @@ int joystick_device_open(struct joystick_device *device, const char *device_path
 	 * Open device and get attributes.
 	 */
 
-	device->device_fd = joystick_open(device_path, &device->input_attrib);
+	struct joystick_input_attrib input_attrib;
+	memset(&input_attrib, 0, sizeof(input_attrib));
+
+	const int device_fd = opener != NULL ? opener->opener_function(device_path, &input_attrib, opener->opener_arg) : joystick_open(device_path, &input_attrib);
+
+	joystick_device_create(device, device_fd, &input_attrib);
+	device->device_opener = opener;
 	
-	if(device->device_fd < 0){
+	if(device_fd < 0){
 		return -1;	
 	}
 
 	return 0;
 }
 
+void joystick_device_create(struct joystick_device *device, int fd, const struct joystick_input_attrib *input_attrib)
+{
+	assert(device != NULL);
+	assert(input_attrib != NULL);
+
+	memset(device, 0, sizeof(struct joystick_device));
+	memcpy(&device->input_attrib, input_attrib, sizeof(struct joystick_input_attrib));
+
+	device->device_fd = fd;
+}
+
 
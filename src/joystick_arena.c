@@ -0,0 +1,46 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_arena.h"
+
+
+void joystick_arena_create(struct joystick_arena *arena, void *memory, size_t size)
+{
+	assert(arena != NULL);
+	assert(memory != NULL || size == 0);
+
+	arena->arena_memory = (uint8_t *)memory;
+	arena->arena_size = size;
+	arena->arena_used = 0;
+}
+
+void *joystick_arena_alloc(struct joystick_arena *arena, size_t size, size_t align)
+{
+	assert(arena != NULL);
+	assert(align != 0 && (align & (align - 1)) == 0);
+
+	/* Align the address, the memory itself might not be aligned. */
+	const uintptr_t base = (uintptr_t)arena->arena_memory;
+	const uintptr_t begin = (base + arena->arena_used + (align - 1)) & ~(uintptr_t)(align - 1);
+	const size_t offset = (size_t)(begin - base);
+
+	if(offset > arena->arena_size || size > arena->arena_size - offset){
+		return NULL;
+	}
+
+	arena->arena_used = offset + size;
+
+	void *memory = arena->arena_memory + offset;
+	memset(memory, 0, size);
+
+	return memory;
+}
+
+void joystick_arena_reset(struct joystick_arena *arena)
+{
+	assert(arena != NULL);
+
+	arena->arena_used = 0;
+}
@@ -0,0 +1,111 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "joystick_curve.h"
+
+
+void joystick_curve_config_default(struct joystick_curve_config *config)
+{
+	assert(config != NULL);
+
+	memset(config, 0, sizeof(struct joystick_curve_config));
+
+	config->config_saturation = 1.0f;
+}
+
+float joystick_curve_evaluate(const struct joystick_curve_config *config, int16_t value)
+{
+	assert(config != NULL);
+
+	float x = ((float)value)/((float)INT16_MAX);
+	if(x < -1.0f){
+		x = -1.0f;
+	}
+
+	float m = x < 0.0f ? -x : x;
+
+	if(m <= config->config_deadzone){
+		return 0.0f;
+	}
+
+	m = (m - config->config_deadzone)/(config->config_saturation - config->config_deadzone);
+	if(m > 1.0f){
+		m = 1.0f;
+	}
+
+	if(config->config_function != NULL){
+		m = config->config_function(m, config->config_function_arg);
+	}
+	else{
+		const float expo = config->config_expo;
+		m = (1.0f - expo)*m + expo*m*m*m;
+	}
+
+	float y = x < 0.0f ? -m : m;
+	if(config->config_invert){
+		y = -y;
+	}
+
+	if(y > 1.0f){
+		y = 1.0f;
+	}
+	else if(y < -1.0f){
+		y = -1.0f;
+	}
+
+	return y;
+}
+
+void joystick_curve_create(struct joystick_curve *curve)
+{
+	assert(curve != NULL);
+
+	memset(curve, 0, sizeof(struct joystick_curve));
+}
+
+void joystick_curve_destroy(struct joystick_curve *curve)
+{
+	assert(curve != NULL);
+
+	for(uint8_t axis = 0; axis < JOYSTICK_AXIS_MAX; axis++){
+		joystick_curve_clear(curve, axis);
+	}
+}
+
+int joystick_curve_set(struct joystick_curve *curve, uint8_t axis, const struct joystick_curve_config *config)
+{
+	assert(curve != NULL);
+	assert(config != NULL);
+	assert(axis < JOYSTICK_AXIS_MAX);
+	assert(config->config_deadzone >= 0.0f);
+	assert(config->config_deadzone < config->config_saturation);
+	assert(config->config_saturation <= 1.0f);
+
+	float *table = curve->curve_table[axis];
+	if(table == NULL){
+		table = malloc(JOYSTICK_CURVE_TABLE_SIZE*sizeof(float));
+		if(table == NULL){
+			return -1;
+		}
+	}
+
+	for(int32_t value = INT16_MIN; value <= INT16_MAX; value++){
+		table[value - INT16_MIN] = joystick_curve_evaluate(config, (int16_t)value);
+	}
+
+	curve->curve_table[axis] = table;
+
+	return 0;
+}
+
+void joystick_curve_clear(struct joystick_curve *curve, uint8_t axis)
+{
+	assert(curve != NULL);
+	assert(axis < JOYSTICK_AXIS_MAX);
+
+	free(curve->curve_table[axis]);
+	curve->curve_table[axis] = NULL;
+}
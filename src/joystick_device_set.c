@@ -0,0 +1,348 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_device_set.h"
+
+
+int joystick_device_set_create(struct joystick_device_set *set)
+{
+	assert(set != NULL);
+
+	memset(set, 0, sizeof(struct joystick_device_set));
+
+	for(size_t i = 0; i < JOYSTICK_DEVICE_SET_MAX; i++){
+		set->set_device[i].device_fd = -1;
+	}
+
+	return joystick_wait_create(&set->set_wait);
+}
+
+int joystick_device_set_destroy(struct joystick_device_set *set)
+{
+	assert(set != NULL);
+
+	for(size_t i = 0; i < set->set_device_count; i++)
+	{
+		struct joystick_device *device = &set->set_device[i];
+		if(joystick_device_is_open(device) > 0){
+			joystick_device_close(device);
+		}
+	}
+
+	set->set_device_count = 0;
+
+	return joystick_wait_destroy(&set->set_wait);
+}
+
+int joystick_device_set_open(struct joystick_device_set *set, const char *device_path)
+{
+	return joystick_device_set_open_with(set, device_path, NULL);
+}
+
+int joystick_device_set_open_with(struct joystick_device_set *set, const char *device_path, const struct joystick_device_opener *opener)
+{
+	assert(set != NULL);
+	assert(device_path != NULL);
+
+	if(set->set_device_count == JOYSTICK_DEVICE_SET_MAX){
+		return -1;
+	}
+
+	const size_t index = set->set_device_count;
+	struct joystick_device *device = &set->set_device[index];
+
+	if(joystick_device_open_with(device, device_path, opener) < 0){
+		return -1;
+	}
+
+	/* The index is used as tag so ready devices are found without searching. */
+	if(joystick_wait_add_device(&set->set_wait, device, index) < 0){
+		joystick_device_close(device);
+		return -1;
+	}
+
+	memset(&set->set_input_value[index], 0, sizeof(struct joystick_input_value));
+	set->set_device_count = index + 1;
+
+	return (int)index;
+}
+
+static int joystick_device_set_reconnect(struct joystick_device_set *set, size_t index)
+{
+	struct joystick_device *device = &set->set_device[index];
+
+	if(joystick_device_reopen(device) <= 0){
+		return -1;
+	}
+
+	if(joystick_wait_add_device(&set->set_wait, device, index) < 0){
+		joystick_device_close(device);
+		return -1;
+	}
+
+	return 0;
+}
+
+size_t joystick_device_set_reopen(struct joystick_device_set *set)
+{
+	assert(set != NULL);
+
+	size_t reopened = 0;
+
+	for(size_t i = 0; i < set->set_device_count; i++)
+	{
+		if(joystick_device_is_open(&set->set_device[i]) > 0){
+			continue;
+		}
+
+		if(joystick_device_set_reconnect(set, i) == 0){
+			reopened = reopened + 1;
+		}
+	}
+
+	return reopened;
+}
+
+/*
+ * Close devices still open at the path of a removed node. Their file
+ * descriptor belongs to the old node, and the add that follows a replaced
+ * node only reopens closed devices.
+ *
+ * @param updates Closed devices are reported here with result -1, as many as
+ * update_max fits. May be NULL.
+ *
+ * @return Returns number of devices that were closed.
+ */
+static size_t joystick_device_set_disconnect(struct joystick_device_set *set, const struct joystick_hotplug_event *event, struct joystick_device_update *updates, size_t update_max)
+{
+	if(event->hotplug_type != JOYSTICK_HOTPLUG_REMOVE){
+		return 0;
+	}
+
+	size_t closed = 0;
+	const char *device_path = (const char *)event->hotplug_input_attrib.joystick_device_path;
+
+	for(size_t i = 0; i < set->set_device_count; i++)
+	{
+		struct joystick_device *device = &set->set_device[i];
+		if(joystick_device_is_open(device) < 0){
+			continue;
+		}
+
+		if(strcmp((const char *)device->input_attrib.joystick_device_path, device_path) != 0){
+			continue;
+		}
+
+		joystick_device_close(device);
+
+		if(updates != NULL && closed < update_max){
+			updates[closed].update_index = i;
+			updates[closed].update_result = -1;
+		}
+
+		closed = closed + 1;
+	}
+
+	return closed;
+}
+
+/*
+ * Reopen closed devices at the path of an added node.
+ *
+ * @param updates Reopened devices are reported here with result 2, as many as
+ * update_max fits. May be NULL.
+ *
+ * @return Returns number of devices that were reopened.
+ */
+static size_t joystick_device_set_connect(struct joystick_device_set *set, const struct joystick_hotplug_event *event, struct joystick_device_update *updates, size_t update_max)
+{
+	if(event->hotplug_type != JOYSTICK_HOTPLUG_ADD){
+		return 0;
+	}
+
+	size_t reopened = 0;
+	const char *device_path = (const char *)event->hotplug_input_attrib.joystick_device_path;
+
+	for(size_t i = 0; i < set->set_device_count; i++)
+	{
+		struct joystick_device *device = &set->set_device[i];
+		if(joystick_device_is_open(device) > 0){
+			continue;
+		}
+
+		if(strcmp((const char *)device->input_attrib.joystick_device_path, device_path) != 0){
+			continue;
+		}
+
+		if(joystick_device_set_reconnect(set, i) < 0){
+			continue;
+		}
+
+		if(updates != NULL && reopened < update_max){
+			updates[reopened].update_index = i;
+			updates[reopened].update_result = 2;
+		}
+
+		reopened = reopened + 1;
+	}
+
+	return reopened;
+}
+
+size_t joystick_device_set_hotplug(struct joystick_device_set *set, const struct joystick_hotplug_event *events, size_t event_count)
+{
+	assert(set != NULL);
+	assert(events != NULL);
+
+	size_t reopened = 0;
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		joystick_device_set_disconnect(set, &events[i], NULL, 0);
+		reopened = reopened + joystick_device_set_connect(set, &events[i], NULL, 0);
+	}
+
+	return reopened;
+}
+
+int joystick_device_set_watch(struct joystick_device_set *set, struct joystick_hotplug *hotplug)
+{
+	assert(set != NULL);
+	assert(hotplug != NULL);
+	assert(set->set_hotplug == NULL);
+
+	if(joystick_wait_add(&set->set_wait, hotplug->hotplug_fd, JOYSTICK_DEVICE_SET_TAG_HOTPLUG) < 0){
+		return -1;
+	}
+
+	set->set_hotplug = hotplug;
+
+	return 0;
+}
+
+struct joystick_device *joystick_device_set_device(struct joystick_device_set *set, size_t index)
+{
+	assert(set != NULL);
+	assert(index < set->set_device_count);
+
+	return &set->set_device[index];
+}
+
+struct joystick_input_value *joystick_device_set_value(struct joystick_device_set *set, size_t index)
+{
+	assert(set != NULL);
+	assert(index < set->set_device_count);
+
+	return &set->set_input_value[index];
+}
+
+/*
+ * Report hotplug events as updates while there is room. Events are taken
+ * from the monitor one at a time, so an event is never taken without room
+ * for its updates and the rest are left for the next poll.
+ *
+ * @return Returns the new update count.
+ */
+static size_t joystick_device_set_process(struct joystick_device_set *set, struct joystick_device_update *updates, size_t update_count, size_t update_max)
+{
+	while(set->set_hotplug_pending && update_count < update_max)
+	{
+		struct joystick_hotplug_event event;
+		int event_count = joystick_hotplug_process(set->set_hotplug, &event, 1);
+
+		/* Lost events, the second call rescans the directory. */
+		if(event_count < 0){
+			event_count = joystick_hotplug_process(set->set_hotplug, &event, 1);
+		}
+
+		if(event_count < 0){
+			joystick_wait_remove(&set->set_wait, set->set_hotplug->hotplug_fd);
+			set->set_hotplug = NULL;
+			set->set_hotplug_pending = 0;
+			break;
+		}
+
+		if(event_count == 0){
+			set->set_hotplug_pending = 0;
+			break;
+		}
+
+		size_t closed = joystick_device_set_disconnect(set, &event, &updates[update_count], update_max - update_count);
+		update_count = update_count + (closed < update_max - update_count ? closed : update_max - update_count);
+
+		size_t reopened = joystick_device_set_connect(set, &event, &updates[update_count], update_max - update_count);
+		update_count = update_count + (reopened < update_max - update_count ? reopened : update_max - update_count);
+	}
+
+	return update_count;
+}
+
+int joystick_device_set_poll(struct joystick_device_set *set, struct joystick_device_update *updates, size_t update_max, int timeout_ms)
+{
+	assert(set != NULL);
+	assert(updates != NULL);
+	assert(update_max > 0);
+
+	uint64_t tags[JOYSTICK_WAIT_EVENT_MAX];
+	const size_t tag_max = update_max < JOYSTICK_WAIT_EVENT_MAX ? update_max : JOYSTICK_WAIT_EVENT_MAX;
+
+	/* Hotplug events left by the last poll are reported without waiting. */
+	int tag_count = joystick_wait_poll(&set->set_wait, tags, tag_max, set->set_hotplug_pending ? 0 : timeout_ms);
+	if(tag_count < 0){
+		return -1;
+	}
+
+	size_t update_count = joystick_device_set_process(set, updates, 0, update_max);
+
+	for(size_t i = 0; i < (size_t)tag_count; i++)
+	{
+		if(tags[i] == JOYSTICK_WAIT_TAG_WAKEUP){
+			continue;
+		}
+
+		if(tags[i] == JOYSTICK_DEVICE_SET_TAG_HOTPLUG)
+		{
+			set->set_hotplug_pending = 1;
+			update_count = joystick_device_set_process(set, updates, update_count, update_max);
+			continue;
+		}
+
+		const size_t index = (size_t)tags[i];
+		assert(index < set->set_device_count);
+
+		/* Closed by a hotplug remove earlier in this wait. */
+		if(joystick_device_is_open(&set->set_device[index]) < 0){
+			continue;
+		}
+
+		/* Devices left unread are reported again by the next poll. */
+		if(update_count == update_max){
+			break;
+		}
+
+		/*
+		 * Closing the device on failure also removes
+		 * it from the epoll set.
+		 */
+
+		int result = joystick_device_poll(&set->set_device[index], &set->set_input_value[index]);
+		if(result == 0){
+			continue;
+		}
+
+		updates[update_count].update_index = index;
+		updates[update_count].update_result = result > 0 ? 1 : -1;
+		update_count = update_count + 1;
+	}
+
+	return (int)update_count;
+}
+
+int joystick_device_set_wakeup(struct joystick_device_set *set)
+{
+	assert(set != NULL);
+
+	return joystick_wait_wakeup(&set->set_wait);
+}
@@ -0,0 +1,151 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_dynamic.h"
+#include "joystick_curve.h"
+#include "joystick_filter.h"
+
+
+size_t joystick_input_dynamic_size(const struct joystick_input_attrib *input_attrib)
+{
+	assert(input_attrib != NULL);
+
+	const size_t axis_count = input_attrib->joystick_axis_count;
+	const size_t button_count = input_attrib->joystick_button_count;
+
+	/* Allocated in order of alignment, only the first may need padding. */
+	return sizeof(uint64_t) - 1
+		+ (JOYSTICK_DYNAMIC_WORDS(axis_count) + 3*JOYSTICK_DYNAMIC_WORDS(button_count))*sizeof(uint64_t)
+		+ axis_count*sizeof(float)
+		+ button_count*sizeof(int16_t);
+}
+
+int joystick_input_dynamic_create(struct joystick_input_dynamic *input_dynamic, const struct joystick_input_attrib *input_attrib, struct joystick_arena *arena)
+{
+	assert(input_dynamic != NULL);
+	assert(input_attrib != NULL);
+	assert(arena != NULL);
+
+	memset(input_dynamic, 0, sizeof(struct joystick_input_dynamic));
+
+	const size_t axis_count = input_attrib->joystick_axis_count;
+	const size_t button_count = input_attrib->joystick_button_count;
+	const size_t axis_words = JOYSTICK_DYNAMIC_WORDS(axis_count);
+	const size_t button_words = JOYSTICK_DYNAMIC_WORDS(button_count);
+
+	/* Masks first, they need the largest alignment. */
+	uint64_t *masks = joystick_arena_alloc(arena, (axis_words + 3*button_words)*sizeof(uint64_t), sizeof(uint64_t));
+	float *axis_value = joystick_arena_alloc(arena, axis_count*sizeof(float), sizeof(float));
+	int16_t *button_value = joystick_arena_alloc(arena, button_count*sizeof(int16_t), sizeof(int16_t));
+
+	if(masks == NULL || axis_value == NULL || button_value == NULL){
+		return -1;
+	}
+
+	input_dynamic->dynamic_axis_count = (uint32_t)axis_count;
+	input_dynamic->dynamic_button_count = (uint32_t)button_count;
+
+	input_dynamic->dynamic_axis_value = axis_value;
+	input_dynamic->dynamic_button_value = button_value;
+
+	input_dynamic->dynamic_axis_changed = masks;
+	input_dynamic->dynamic_button_pressed = masks + axis_words;
+	input_dynamic->dynamic_button_released = masks + axis_words + button_words;
+	input_dynamic->dynamic_button_changed = masks + axis_words + 2*button_words;
+
+	return 0;
+}
+
+void joystick_input_dynamic_clear_changed(struct joystick_input_dynamic *input_dynamic)
+{
+	assert(input_dynamic != NULL);
+
+	const size_t axis_words = JOYSTICK_DYNAMIC_WORDS(input_dynamic->dynamic_axis_count);
+	const size_t button_words = JOYSTICK_DYNAMIC_WORDS(input_dynamic->dynamic_button_count);
+
+	/* The masks are contiguous. */
+	memset(input_dynamic->dynamic_axis_changed, 0, (axis_words + 3*button_words)*sizeof(uint64_t));
+}
+
+int joystick_device_poll_dynamic(struct joystick_device *device, struct joystick_input_dynamic *input_dynamic)
+{
+	assert(device != NULL);
+	assert(input_dynamic != NULL);
+
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	int event_count = joystick_device_read(device, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE);
+	if(event_count <= 0){
+		return event_count;
+	}
+
+	joystick_input_dynamic_clear_changed(input_dynamic);
+	joystick_device_decode_dynamic(device, js_event_buffer, (size_t)event_count, input_dynamic);
+
+	return 1;
+}
+
+void joystick_device_decode_dynamic(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_dynamic *input_dynamic)
+{
+	assert(device != NULL);
+	assert(events != NULL);
+	assert(input_dynamic != NULL);
+
+	const struct joystick_curve *curve = device->device_curve;
+	struct joystick_filter *filter = device->device_filter;
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		const uint8_t number = events[i].number;
+		const int16_t value = events[i].value;
+		const uint64_t bit = (uint64_t)1 << (number%64);
+
+		switch(events[i].type & ~JS_EVENT_INIT)
+		{
+			case JS_EVENT_AXIS:
+				if(number < input_dynamic->dynamic_axis_count){
+					float mapped;
+
+					if(number < JOYSTICK_AXIS_MAX)
+					{
+						mapped = curve != NULL ? joystick_curve_apply(curve, number, value) : ((float)value)/((float)INT16_MAX);
+
+						if(filter != NULL){
+							mapped = events[i].type & JS_EVENT_INIT ? joystick_filter_start(filter, number, mapped, events[i].time) : joystick_filter_apply(filter, number, mapped, events[i].time);
+						}
+					}
+					else{
+						/* Map INT16_T range to float [-1, 1] */
+						mapped = ((float)value)/((float)INT16_MAX);
+					}
+
+					input_dynamic->dynamic_axis_value[number] = mapped;
+					input_dynamic->dynamic_axis_changed[number/64] |= bit;
+					input_dynamic->dynamic_event_time = events[i].time;
+				}
+			break;
+
+			case JS_EVENT_BUTTON:
+				if(number < input_dynamic->dynamic_button_count){
+					int16_t *button_value = &input_dynamic->dynamic_button_value[number];
+
+					/* INIT events report the state, not a press or release. */
+					if(!(events[i].type & JS_EVENT_INIT) && (value != 0) != (*button_value != 0)){
+						if(value != 0){
+							input_dynamic->dynamic_button_pressed[number/64] |= bit;
+						}
+						else{
+							input_dynamic->dynamic_button_released[number/64] |= bit;
+						}
+
+						input_dynamic->dynamic_button_changed[number/64] |= bit;
+					}
+
+					*button_value = value;
+					input_dynamic->dynamic_event_time = events[i].time;
+				}
+			break;
+		}
+	}
+}
@@ -0,0 +1,391 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/ioctl.h>
+
+#include "joystick_evdev.h"
+#include "joystick_stats.h"
+
+#define JOYSTICK_EVDEV_LONG_BITS 	(sizeof(unsigned long)*8)
+#define JOYSTICK_EVDEV_LONGS(bits) 	(((bits) + JOYSTICK_EVDEV_LONG_BITS - 1)/JOYSTICK_EVDEV_LONG_BITS)
+
+
+static int joystick_evdev_test_bit(const unsigned long *bitmap, size_t bit)
+{
+	return (bitmap[bit/JOYSTICK_EVDEV_LONG_BITS] >> (bit%JOYSTICK_EVDEV_LONG_BITS)) & 1UL ? 1 : 0;
+}
+
+/*
+ * Map absolute axis value to [-1, 1].
+ */
+static float joystick_evdev_normalize(const struct joystick_evdev_axis *axis, int32_t value)
+{
+	const float offset = (float)value - axis->axis_center;
+	const float magnitude = (offset < 0.0f ? -offset : offset) - axis->axis_flat;
+
+	if(magnitude <= 0.0f){
+		return 0.0f;
+	}
+
+	float mapped = magnitude*axis->axis_scale;
+	if(mapped > 1.0f){
+		mapped = 1.0f;
+	}
+
+	return offset < 0.0f ? -mapped : mapped;
+}
+
+/*
+ * Set button value and record the press or release.
+ */
+static void joystick_evdev_set_button(struct joystick_input_value *pending, uint8_t number, int16_t value)
+{
+	const uint32_t bit = 1u << number;
+
+	if(value != pending->joystick_button_value[number])
+	{
+		if(value){
+			pending->joystick_button_pressed |= bit;
+		}
+		else{
+			pending->joystick_button_released |= bit;
+		}
+
+		pending->joystick_button_changed |= bit;
+	}
+
+	pending->joystick_button_value[number] = value;
+}
+
+/*
+ * Read the current state of every axis and button from the device.
+ * Does nothing for file descriptors that are not evdev devices.
+ */
+static void joystick_evdev_sync(struct joystick_evdev *evdev)
+{
+	struct joystick_input_value *pending = &evdev->evdev_pending;
+
+	for(uint32_t i = 0; i < evdev->evdev_input_attrib.joystick_axis_count; i++)
+	{
+		struct input_absinfo absinfo;
+		if(ioctl(evdev->evdev_fd, EVIOCGABS((unsigned int)evdev->evdev_axis_code[i]), &absinfo) < 0){
+			return;
+		}
+
+		pending->joystick_axis_value[i] = joystick_evdev_normalize(&evdev->evdev_axis[i], absinfo.value);
+		pending->joystick_axis_changed |= 1u << i;
+	}
+
+	unsigned long key_bitmap[JOYSTICK_EVDEV_LONGS(KEY_CNT)];
+	memset(key_bitmap, 0, sizeof key_bitmap);
+
+	if(ioctl(evdev->evdev_fd, EVIOCGKEY(sizeof key_bitmap), key_bitmap) < 0){
+		return;
+	}
+
+	for(uint32_t i = 0; i < evdev->evdev_input_attrib.joystick_button_count; i++){
+		joystick_evdev_set_button(pending, (uint8_t)i, (int16_t)joystick_evdev_test_bit(key_bitmap, evdev->evdev_button_code[i]));
+	}
+}
+
+void joystick_evdev_create(struct joystick_evdev *evdev, int fd)
+{
+	assert(evdev != NULL);
+
+	memset(evdev, 0, sizeof(struct joystick_evdev));
+	memset(evdev->evdev_axis_map, JOYSTICK_EVDEV_UNMAPPED, sizeof evdev->evdev_axis_map);
+	memset(evdev->evdev_button_map, JOYSTICK_EVDEV_UNMAPPED, sizeof evdev->evdev_button_map);
+
+	evdev->evdev_fd = fd;
+}
+
+int joystick_evdev_add_axis(struct joystick_evdev *evdev, uint16_t code, const struct input_absinfo *absinfo)
+{
+	assert(evdev != NULL);
+	assert(absinfo != NULL);
+	assert(code < ABS_CNT);
+	assert(evdev->evdev_axis_map[code] == JOYSTICK_EVDEV_UNMAPPED);
+
+	const uint8_t number = evdev->evdev_input_attrib.joystick_axis_count;
+	if(number == JOYSTICK_AXIS_MAX){
+		return -1;
+	}
+
+	struct joystick_evdev_axis *axis = &evdev->evdev_axis[number];
+
+	const float half_range = ((float)absinfo->maximum - (float)absinfo->minimum)/2.0f;
+	const float flat = (float)absinfo->flat < half_range ? (float)absinfo->flat : 0.0f;
+
+	/*
+	 * The kernel already filters changes smaller than fuzz,
+	 * only the flat area is handled here.
+	 */
+	axis->axis_center = ((float)absinfo->maximum + (float)absinfo->minimum)/2.0f;
+	axis->axis_flat = flat;
+	axis->axis_scale = half_range - flat > 0.0f ? 1.0f/(half_range - flat) : 0.0f;
+
+	evdev->evdev_axis_map[code] = number;
+	evdev->evdev_axis_code[number] = code;
+	evdev->evdev_pending.joystick_axis_value[number] = joystick_evdev_normalize(axis, absinfo->value);
+	evdev->evdev_frame.joystick_axis_value[number] = evdev->evdev_pending.joystick_axis_value[number];
+	evdev->evdev_pending.joystick_axis_changed |= 1u << number;
+	evdev->evdev_input_attrib.joystick_axis_count = (uint8_t)(number + 1);
+
+	return number;
+}
+
+int joystick_evdev_add_button(struct joystick_evdev *evdev, uint16_t code)
+{
+	assert(evdev != NULL);
+	assert(code >= BTN_MISC && code < KEY_CNT);
+	assert(evdev->evdev_button_map[code - BTN_MISC] == JOYSTICK_EVDEV_UNMAPPED);
+
+	const uint8_t number = evdev->evdev_input_attrib.joystick_button_count;
+	if(number == JOYSTICK_BUTTON_MAX){
+		return -1;
+	}
+
+	evdev->evdev_button_map[code - BTN_MISC] = number;
+	evdev->evdev_button_code[number] = code;
+	evdev->evdev_input_attrib.joystick_button_count = (uint8_t)(number + 1);
+
+	return number;
+}
+
+int joystick_evdev_open(struct joystick_evdev *evdev, const char *device_path)
+{
+	assert(evdev != NULL);
+	assert(device_path != NULL);
+
+	int device_fd = open(device_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if(device_fd < 0){
+		return -1;
+	}
+
+	joystick_evdev_create(evdev, device_fd);
+
+	unsigned long abs_bitmap[JOYSTICK_EVDEV_LONGS(ABS_CNT)];
+	unsigned long key_bitmap[JOYSTICK_EVDEV_LONGS(KEY_CNT)];
+	memset(abs_bitmap, 0, sizeof abs_bitmap);
+	memset(key_bitmap, 0, sizeof key_bitmap);
+
+	/* Will be null terminated */
+	char name[JOYSTICK_NAME_LENGTH];
+	memset(name, 0, sizeof name);
+
+	if(ioctl(device_fd, EVIOCGNAME(sizeof name - 1), name) < 0){
+		goto exit;
+	}
+
+	if(ioctl(device_fd, EVIOCGBIT(EV_ABS, sizeof abs_bitmap), abs_bitmap) < 0){
+		goto exit;
+	}
+
+	if(ioctl(device_fd, EVIOCGBIT(EV_KEY, sizeof key_bitmap), key_bitmap) < 0){
+		goto exit;
+	}
+
+	/*
+	 * Number axes in code order, like joydev.
+	 */
+	for(uint16_t code = 0; code < ABS_CNT; code++)
+	{
+		if(!joystick_evdev_test_bit(abs_bitmap, code)){
+			continue;
+		}
+
+		struct input_absinfo absinfo;
+		if(ioctl(device_fd, EVIOCGABS((unsigned int)code), &absinfo) < 0){
+			goto exit;
+		}
+
+		if(joystick_evdev_add_axis(evdev, code, &absinfo) < 0){
+			goto exit;
+		}
+	}
+
+	/*
+	 * Number buttons like joydev, joystick buttons first
+	 * and then the miscellaneous buttons below them.
+	 */
+	for(uint16_t code = BTN_JOYSTICK; code < KEY_CNT; code++)
+	{
+		if(joystick_evdev_test_bit(key_bitmap, code) && joystick_evdev_add_button(evdev, code) < 0){
+			goto exit;
+		}
+	}
+
+	for(uint16_t code = BTN_MISC; code < BTN_JOYSTICK; code++)
+	{
+		if(joystick_evdev_test_bit(key_bitmap, code) && joystick_evdev_add_button(evdev, code) < 0){
+			goto exit;
+		}
+	}
+
+	/* Same clock as the rest of the library. Old kernels keep the default. */
+	int clock_id = CLOCK_MONOTONIC;
+	ioctl(device_fd, EVIOCSCLOCKID, &clock_id);
+
+	strncpy((char *)evdev->evdev_input_attrib.joystick_name, name, sizeof(evdev->evdev_input_attrib.joystick_name));
+
+	/* +1 for NULL */
+	size_t device_path_len = strlen(device_path) + 1;
+	if(device_path_len > sizeof evdev->evdev_input_attrib.joystick_device_path){
+		goto exit;
+	}
+
+	memcpy(evdev->evdev_input_attrib.joystick_device_path, device_path, device_path_len);
+
+	joystick_evdev_sync(evdev);
+
+	/* Buttons held when opened are state, not presses. */
+	evdev->evdev_pending.joystick_button_pressed = 0;
+	evdev->evdev_pending.joystick_button_changed = 0;
+	memcpy(&evdev->evdev_frame, &evdev->evdev_pending, sizeof(struct joystick_input_value));
+
+	return 0;
+
+exit:
+	close(device_fd);
+	evdev->evdev_fd = -1;
+	return -1;
+}
+
+int joystick_evdev_close(struct joystick_evdev *evdev)
+{
+	assert(evdev != NULL);
+
+	close(evdev->evdev_fd);
+	evdev->evdev_fd = -1;
+
+	return 0;
+}
+
+int joystick_evdev_use_stats(struct joystick_evdev *evdev, struct joystick_stats *stats)
+{
+	assert(evdev != NULL);
+
+	if(!joystick_stats_enabled()){
+		return -1;
+	}
+
+	evdev->evdev_stats = stats;
+
+	return 0;
+}
+
+int joystick_evdev_decode(struct joystick_evdev *evdev, const struct input_event *events, size_t event_count, struct joystick_input_value *input_value)
+{
+	assert(evdev != NULL);
+	assert(events != NULL);
+	assert(input_value != NULL);
+
+	struct joystick_input_value *pending = &evdev->evdev_pending;
+	int result = 0;
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		const struct input_event *event = &events[i];
+
+		if(event->type == EV_SYN)
+		{
+			if(event->code == SYN_DROPPED)
+			{
+				/* Drop the part of the frame read before the loss too. */
+				memcpy(pending, &evdev->evdev_frame, sizeof(struct joystick_input_value));
+				joystick_input_value_clear_changed(pending);
+				evdev->evdev_dropped = 1;
+			}
+			else if(event->code == SYN_REPORT)
+			{
+				if(evdev->evdev_dropped){
+					/* Events of the broken frame are unreliable, read the state instead. */
+					joystick_evdev_sync(evdev);
+					evdev->evdev_dropped = 0;
+				}
+
+				/* Changes of every frame completed in this call. */
+				if(result){
+					pending->joystick_axis_changed |= input_value->joystick_axis_changed;
+					pending->joystick_button_pressed |= input_value->joystick_button_pressed;
+					pending->joystick_button_released |= input_value->joystick_button_released;
+					pending->joystick_button_changed |= input_value->joystick_button_changed;
+				}
+
+				pending->joystick_event_time = (uint32_t)((uint64_t)event->input_event_sec*1000 + (uint64_t)event->input_event_usec/1000);
+				memcpy(input_value, pending, sizeof(struct joystick_input_value));
+				memcpy(&evdev->evdev_frame, pending, sizeof(struct joystick_input_value));
+				joystick_input_value_clear_changed(pending);
+				result = 1;
+			}
+
+			continue;
+		}
+
+		if(evdev->evdev_dropped){
+			continue;
+		}
+
+		if(event->type == EV_ABS && event->code < ABS_CNT)
+		{
+			const uint8_t number = evdev->evdev_axis_map[event->code];
+			if(number != JOYSTICK_EVDEV_UNMAPPED){
+				pending->joystick_axis_value[number] = joystick_evdev_normalize(&evdev->evdev_axis[number], event->value);
+				pending->joystick_axis_changed |= 1u << number;
+			}
+		}
+		else if(event->type == EV_KEY && event->code >= BTN_MISC && event->code < KEY_CNT)
+		{
+			const uint8_t number = evdev->evdev_button_map[event->code - BTN_MISC];
+			if(number != JOYSTICK_EVDEV_UNMAPPED){
+				/* Auto repeat, value 2, is still pressed. */
+				joystick_evdev_set_button(pending, number, event->value ? 1 : 0);
+			}
+		}
+	}
+
+	return result;
+}
+
+int joystick_evdev_poll(struct joystick_evdev *evdev, struct joystick_input_value *input_value)
+{
+	assert(evdev != NULL);
+	assert(input_value != NULL);
+
+	struct input_event event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	ssize_t bytes_read = read(evdev->evdev_fd, event_buffer, sizeof event_buffer);
+	if(bytes_read <= 0){
+		if(bytes_read < 0 && errno == EAGAIN){
+#ifdef JOYSTICK_STATS
+			if(evdev->evdev_stats != NULL){
+				joystick_stats_read_evdev(evdev->evdev_stats, 0, event_buffer, 0);
+			}
+#endif
+			return 0;
+		}
+
+		joystick_evdev_close(evdev);
+#ifdef JOYSTICK_STATS
+		if(evdev->evdev_stats != NULL){
+			joystick_stats_disconnect(evdev->evdev_stats);
+		}
+#endif
+		return -1;
+	}
+
+	const size_t event_count = ((size_t)bytes_read)/sizeof(struct input_event);
+
+#ifdef JOYSTICK_STATS
+	if(evdev->evdev_stats != NULL){
+		joystick_stats_read_evdev(evdev->evdev_stats, (size_t)bytes_read, event_buffer, event_count);
+	}
+#endif
+
+	return joystick_evdev_decode(evdev, event_buffer, event_count, input_value);
+}
@@ -0,0 +1,225 @@
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_filter.h"
+
+#define JOYSTICK_FILTER_PI 3.14159265358979f
+
+
+/*
+ * Time constant of a first order low-pass with cutoff in Hz.
+ */
+static float joystick_filter_tau(float cutoff)
+{
+	return 1.0f/(2.0f*JOYSTICK_FILTER_PI*cutoff);
+}
+
+/*
+ * Smoothing factor of a first order low-pass over dt seconds.
+ */
+static float joystick_filter_alpha(float tau, float dt)
+{
+	return 1.0f/(1.0f + tau/dt);
+}
+
+/*
+ * One sample of the biquad, direct form II transposed. b1 = 2 b0 and
+ * b2 = b0 for a low-pass.
+ */
+static float joystick_filter_biquad_step(const float *coefficient, float *state, float x)
+{
+	const float b0 = coefficient[0];
+	const float a1 = coefficient[1];
+	const float a2 = coefficient[2];
+
+	const float y = b0*x + state[0];
+	state[0] = 2.0f*b0*x - a1*y + state[1];
+	state[1] = b0*x - a2*y;
+
+	return y;
+}
+
+/*
+ * Biquad settled on a constant input x, where y = x.
+ */
+static void joystick_filter_biquad_settle(const float *coefficient, float *state, float x)
+{
+	state[0] = x*(1.0f - coefficient[0]);
+	state[1] = x*(coefficient[0] - coefficient[2]);
+}
+
+void joystick_filter_create(struct joystick_filter *filter)
+{
+	assert(filter != NULL);
+
+	memset(filter, 0, sizeof(struct joystick_filter));
+}
+
+void joystick_filter_config_default(struct joystick_filter_config *config, enum joystick_filter_type type)
+{
+	assert(config != NULL);
+
+	memset(config, 0, sizeof(struct joystick_filter_config));
+
+	config->config_type = type;
+	config->config_cutoff = 10.0f;
+	config->config_beta = 0.01f;
+	config->config_derivative_cutoff = 1.0f;
+	config->config_q = 0.7071f;
+}
+
+void joystick_filter_set(struct joystick_filter *filter, uint8_t axis, const struct joystick_filter_config *config)
+{
+	assert(filter != NULL);
+	assert(config != NULL);
+	assert(axis < JOYSTICK_AXIS_MAX);
+
+	struct joystick_filter_axis *filter_axis = &filter->filter_axis[axis];
+	memset(filter_axis, 0, sizeof(struct joystick_filter_axis));
+
+	float *coefficient = filter_axis->axis_coefficient;
+
+	switch(config->config_type)
+	{
+		case JOYSTICK_FILTER_NONE:
+		break;
+
+		case JOYSTICK_FILTER_LOW_PASS:
+			assert(config->config_cutoff > 0.0f);
+
+			coefficient[0] = joystick_filter_tau(config->config_cutoff);
+		break;
+
+		case JOYSTICK_FILTER_ONE_EURO:
+			assert(config->config_cutoff > 0.0f);
+			assert(config->config_derivative_cutoff > 0.0f);
+			assert(config->config_beta >= 0.0f);
+
+			coefficient[0] = joystick_filter_tau(config->config_cutoff);
+			coefficient[1] = config->config_beta;
+			coefficient[2] = joystick_filter_tau(config->config_derivative_cutoff);
+		break;
+
+		case JOYSTICK_FILTER_BIQUAD:
+		{
+			assert(config->config_cutoff > 0.0f);
+			assert(config->config_cutoff < JOYSTICK_FILTER_BIQUAD_RATE/2);
+			assert(config->config_q > 0.0f);
+
+			/* Low-pass from the Audio EQ Cookbook. */
+			const float w0 = 2.0f*JOYSTICK_FILTER_PI*config->config_cutoff/(float)JOYSTICK_FILTER_BIQUAD_RATE;
+			const float alpha = sinf(w0)/(2.0f*config->config_q);
+			const float a0 = 1.0f + alpha;
+
+			coefficient[0] = (1.0f - cosf(w0))/2.0f/a0;
+			coefficient[1] = -2.0f*cosf(w0)/a0;
+			coefficient[2] = (1.0f - alpha)/a0;
+		}
+		break;
+	}
+
+	filter_axis->axis_type = (uint8_t)config->config_type;
+}
+
+void joystick_filter_reset(struct joystick_filter *filter)
+{
+	assert(filter != NULL);
+
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++){
+		filter->filter_axis[i].axis_started = 0;
+	}
+}
+
+float joystick_filter_start(struct joystick_filter *filter, uint8_t axis, float value, uint32_t time)
+{
+	assert(filter != NULL);
+	assert(axis < JOYSTICK_AXIS_MAX);
+
+	struct joystick_filter_axis *filter_axis = &filter->filter_axis[axis];
+	float *state = filter_axis->axis_state;
+
+	state[0] = value;
+	state[1] = 0.0f;
+	state[2] = 0.0f;
+
+	if(filter_axis->axis_type == JOYSTICK_FILTER_BIQUAD){
+		joystick_filter_biquad_settle(filter_axis->axis_coefficient, state, value);
+		state[2] = value;
+	}
+
+	filter_axis->axis_time = time;
+	filter_axis->axis_started = 1;
+
+	return value;
+}
+
+float joystick_filter_apply(struct joystick_filter *filter, uint8_t axis, float value, uint32_t time)
+{
+	assert(filter != NULL);
+	assert(axis < JOYSTICK_AXIS_MAX);
+
+	struct joystick_filter_axis *filter_axis = &filter->filter_axis[axis];
+
+	if(filter_axis->axis_type == JOYSTICK_FILTER_NONE){
+		return value;
+	}
+
+	if(!filter_axis->axis_started){
+		return joystick_filter_start(filter, axis, value, time);
+	}
+
+	/* Wraps like the event time. */
+	uint32_t dt_ms = time - filter_axis->axis_time;
+	if(dt_ms == 0){
+		dt_ms = 1;
+	}
+
+	filter_axis->axis_time = time;
+
+	const float *coefficient = filter_axis->axis_coefficient;
+	float *state = filter_axis->axis_state;
+	const float dt = (float)dt_ms/1000.0f;
+
+	switch(filter_axis->axis_type)
+	{
+		case JOYSTICK_FILTER_LOW_PASS:
+			state[0] = state[0] + joystick_filter_alpha(coefficient[0], dt)*(value - state[0]);
+		return state[0];
+
+		case JOYSTICK_FILTER_ONE_EURO:
+		{
+			/* Speed estimate, filtered with a fixed cutoff. */
+			const float dx = (value - state[0])/dt;
+			state[1] = state[1] + joystick_filter_alpha(coefficient[2], dt)*(dx - state[1]);
+
+			/* Cutoff rises with speed, less lag on fast moves. */
+			const float speed = state[1] < 0.0f ? -state[1] : state[1];
+			const float tau = coefficient[0]/(1.0f + coefficient[1]*speed*2.0f*JOYSTICK_FILTER_PI*coefficient[0]);
+
+			state[0] = state[0] + joystick_filter_alpha(tau, dt)*(value - state[0]);
+		}
+		return state[0];
+
+		case JOYSTICK_FILTER_BIQUAD:
+		{
+			/* Samples between the events see the previous value. */
+			const uint32_t held_count = dt_ms - 1;
+			if(held_count > JOYSTICK_FILTER_BIQUAD_STEP_MAX){
+				joystick_filter_biquad_settle(coefficient, state, state[2]);
+			}
+			else{
+				for(uint32_t i = 0; i < held_count; i++){
+					joystick_filter_biquad_step(coefficient, state, state[2]);
+				}
+			}
+
+			state[2] = value;
+		}
+		return joystick_filter_biquad_step(coefficient, state, value);
+	}
+
+	return value;
+}
@@ -0,0 +1,360 @@
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/inotify.h>
+
+#include "joystick_hotplug.h"
+
+#define JOYSTICK_HOTPLUG_WATCH_MASK (IN_CREATE | IN_ATTRIB | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#define JOYSTICK_HOTPLUG_REMOVE_MASK (IN_DELETE | IN_MOVED_FROM)
+
+
+/*
+ * Get N from a node named jsN.
+ *
+ * @return Returns 0 on success. -1 if the name is not a joystick node.
+ */
+static int joystick_hotplug_number(const char *name, uint32_t *number)
+{
+	if(strncmp(name, "js", 2) != 0){
+		return -1;
+	}
+
+	const char *digit = name + 2;
+	if(*digit == '\0'){
+		return -1;
+	}
+
+	uint32_t value = 0;
+	for(; *digit != '\0'; digit++)
+	{
+		if(*digit < '0' || *digit > '9'){
+			return -1;
+		}
+
+		value = value*10 + (uint32_t)(*digit - '0');
+		if(value >= JOYSTICK_HOTPLUG_NUMBER_MAX){
+			return -1;
+		}
+	}
+
+	*number = value;
+	return 0;
+}
+
+static void joystick_hotplug_mark(struct joystick_hotplug *hotplug, uint32_t number)
+{
+	hotplug->hotplug_dirty[number/32] |= (uint32_t)1 << (number%32);
+}
+
+/*
+ * Mark every node that is either in the registry or in the directory.
+ * Used when inotify events have been lost.
+ */
+static void joystick_hotplug_mark_all(struct joystick_hotplug *hotplug)
+{
+	for(size_t i = 0; i < hotplug->hotplug_count; i++)
+	{
+		const char *path = (const char *)hotplug->hotplug_registry[i].joystick_device_path;
+		const char *name = strrchr(path, '/');
+
+		uint32_t number;
+		if(joystick_hotplug_number(name != NULL ? name + 1 : path, &number) == 0){
+			joystick_hotplug_mark(hotplug, number);
+		}
+	}
+
+	DIR *dir = opendir(hotplug->hotplug_dir_path);
+	if(dir == NULL){
+		return;
+	}
+
+	struct dirent *dirent = NULL;
+	while((dirent = readdir(dir)) != NULL)
+	{
+		uint32_t number;
+		if(joystick_hotplug_number(dirent->d_name, &number) == 0){
+			joystick_hotplug_mark(hotplug, number);
+		}
+	}
+
+	closedir(dir);
+}
+
+/*
+ * Same as joystick_device_probe, with the opener of the monitor.
+ */
+static int joystick_hotplug_probe(struct joystick_hotplug *hotplug, const char *device_path, struct joystick_input_attrib *input_attrib)
+{
+	const struct joystick_device_opener *opener = hotplug->hotplug_opener;
+	if(opener == NULL){
+		return joystick_device_probe(device_path, input_attrib);
+	}
+
+	const int device_fd = opener->opener_function(device_path, input_attrib, opener->opener_arg);
+	if(device_fd < 0){
+		return -1;
+	}
+
+	close(device_fd);
+	return 0;
+}
+
+static int joystick_hotplug_find(struct joystick_hotplug *hotplug, const char *device_path)
+{
+	for(size_t i = 0; i < hotplug->hotplug_count; i++)
+	{
+		if(strcmp((const char *)hotplug->hotplug_registry[i].joystick_device_path, device_path) == 0){
+			return (int)i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Probe every marked node and bring the registry up to date.
+ *
+ * @param events NULL to update silently.
+ *
+ * @return Returns number of events written.
+ */
+static size_t joystick_hotplug_update(struct joystick_hotplug *hotplug, struct joystick_hotplug_event *events, size_t event_max)
+{
+	size_t event_count = 0;
+
+	for(uint32_t number = 0; number < JOYSTICK_HOTPLUG_NUMBER_MAX; number++)
+	{
+		const uint32_t bit = (uint32_t)1 << (number%32);
+		if((hotplug->hotplug_dirty[number/32] & bit) == 0){
+			continue;
+		}
+
+		if(events != NULL && event_count == event_max){
+			break;
+		}
+
+		const int removed = (hotplug->hotplug_removed[number/32] & bit) != 0;
+
+		hotplug->hotplug_dirty[number/32] &= ~bit;
+		hotplug->hotplug_removed[number/32] &= ~bit;
+
+		char device_path[PATH_MAX];
+		int length = snprintf(device_path, sizeof device_path, "%sjs%u", hotplug->hotplug_dir_path, (unsigned)number);
+		if(length < 0 || (size_t)length >= sizeof device_path){
+			continue;
+		}
+
+		struct joystick_input_attrib input_attrib;
+		memset(&input_attrib, 0, sizeof input_attrib);
+
+		const int present = joystick_hotplug_probe(hotplug, device_path, &input_attrib) == 0;
+		int index = joystick_hotplug_find(hotplug, device_path);
+
+		/*
+		 * A node seen again after a delete, or probed as another joystick,
+		 * is a new device even though it is at the same path.
+		 */
+		const int replaced = present && index >= 0
+			&& (removed || memcmp(&hotplug->hotplug_registry[index], &input_attrib, sizeof input_attrib) != 0);
+
+		if(index >= 0 && (!present || replaced))
+		{
+			if(events != NULL){
+				events[event_count].hotplug_type = JOYSTICK_HOTPLUG_REMOVE;
+				memcpy(&events[event_count].hotplug_input_attrib, &hotplug->hotplug_registry[index], sizeof input_attrib);
+				event_count = event_count + 1;
+			}
+
+			/* Keep the registry in the order devices were found. */
+			const size_t tail = hotplug->hotplug_count - (size_t)index - 1;
+			memmove(&hotplug->hotplug_registry[index], &hotplug->hotplug_registry[index + 1], tail*sizeof input_attrib);
+			hotplug->hotplug_count = hotplug->hotplug_count - 1;
+			index = -1;
+		}
+
+		if(present && index < 0)
+		{
+			/* Left pending, the add is reported by a later call. */
+			if((events != NULL && event_count == event_max) || hotplug->hotplug_count == JOYSTICK_HOTPLUG_MAX){
+				hotplug->hotplug_dirty[number/32] |= bit;
+				continue;
+			}
+
+			memcpy(&hotplug->hotplug_registry[hotplug->hotplug_count], &input_attrib, sizeof input_attrib);
+			hotplug->hotplug_count = hotplug->hotplug_count + 1;
+
+			if(events != NULL){
+				events[event_count].hotplug_type = JOYSTICK_HOTPLUG_ADD;
+				memcpy(&events[event_count].hotplug_input_attrib, &input_attrib, sizeof input_attrib);
+				event_count = event_count + 1;
+			}
+		}
+	}
+
+	return event_count;
+}
+
+int joystick_hotplug_create(struct joystick_hotplug *hotplug, const char *dir_path)
+{
+	return joystick_hotplug_create_with(hotplug, dir_path, NULL);
+}
+
+int joystick_hotplug_create_with(struct joystick_hotplug *hotplug, const char *dir_path, const struct joystick_device_opener *opener)
+{
+	assert(hotplug != NULL);
+
+	memset(hotplug, 0, sizeof(struct joystick_hotplug));
+	hotplug->hotplug_opener = opener;
+
+	if(dir_path == NULL){
+		dir_path = "/dev/input/";
+	}
+
+	/* Stored with trailing separator. */
+	size_t dir_path_length = strlen(dir_path);
+	if(dir_path_length == 0 || dir_path_length + 2 > sizeof hotplug->hotplug_dir_path){
+		return -1;
+	}
+
+	memcpy(hotplug->hotplug_dir_path, dir_path, dir_path_length + 1);
+	if(dir_path[dir_path_length - 1] != '/'){
+		hotplug->hotplug_dir_path[dir_path_length] = '/';
+		hotplug->hotplug_dir_path[dir_path_length + 1] = '\0';
+	}
+
+	hotplug->hotplug_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(hotplug->hotplug_fd < 0){
+		return -1;
+	}
+
+	/* Watch before scanning so no device is missed in between. */
+	hotplug->hotplug_watch = inotify_add_watch(hotplug->hotplug_fd, hotplug->hotplug_dir_path, JOYSTICK_HOTPLUG_WATCH_MASK);
+	if(hotplug->hotplug_watch < 0){
+		close(hotplug->hotplug_fd);
+		hotplug->hotplug_fd = -1;
+		return -1;
+	}
+
+	joystick_hotplug_mark_all(hotplug);
+	joystick_hotplug_update(hotplug, NULL, 0);
+
+	return 0;
+}
+
+int joystick_hotplug_destroy(struct joystick_hotplug *hotplug)
+{
+	assert(hotplug != NULL);
+
+	if(hotplug->hotplug_fd >= 0){
+		close(hotplug->hotplug_fd);
+		hotplug->hotplug_fd = -1;
+	}
+
+	hotplug->hotplug_count = 0;
+
+	return 0;
+}
+
+int joystick_hotplug_process(struct joystick_hotplug *hotplug, struct joystick_hotplug_event *events, size_t event_max)
+{
+	assert(hotplug != NULL);
+	assert(events != NULL);
+	assert(event_max > 0);
+
+	/* Large enough for several events with names of any length. */
+	char buffer[16*(sizeof(struct inotify_event) + NAME_MAX + 1)] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	/* The directory is gone, nothing more will be reported. */
+	if(hotplug->hotplug_watch < 0){
+		return -1;
+	}
+
+	int lost = 0;
+
+	while(1)
+	{
+		ssize_t bytes_read = read(hotplug->hotplug_fd, buffer, sizeof buffer);
+		if(bytes_read < 0)
+		{
+			if(errno == EAGAIN){
+				break;
+			}
+
+			if(errno == EINTR){
+				continue;
+			}
+
+			return -1;
+		}
+
+		size_t offset = 0;
+		while(offset + sizeof(struct inotify_event) <= (size_t)bytes_read)
+		{
+			const struct inotify_event *event = (const struct inotify_event *)(void *)(buffer + offset);
+			offset = offset + sizeof(struct inotify_event) + event->len;
+
+			/* Rescanned by the next call, the caller learns the registry may be stale. */
+			if(event->mask & (IN_Q_OVERFLOW | IN_IGNORED))
+			{
+				if(event->mask & IN_IGNORED){
+					hotplug->hotplug_watch = -1;
+				}
+
+				joystick_hotplug_mark_all(hotplug);
+				lost = 1;
+				continue;
+			}
+
+			uint32_t number;
+			if(event->len > 0 && joystick_hotplug_number(event->name, &number) == 0)
+			{
+				joystick_hotplug_mark(hotplug, number);
+
+				if(event->mask & JOYSTICK_HOTPLUG_REMOVE_MASK){
+					hotplug->hotplug_removed[number/32] |= (uint32_t)1 << (number%32);
+				}
+			}
+		}
+	}
+
+	if(lost){
+		return -1;
+	}
+
+	return (int)joystick_hotplug_update(hotplug, events, event_max);
+}
+
+size_t joystick_hotplug_identify_by_requirement(struct joystick_hotplug *hotplug, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
+{
+	assert(hotplug != NULL);
+	assert(input_requirement != NULL);
+	assert(input_attrib != NULL);
+	assert(input_attrib_max > 0);
+
+	size_t joystick_device_found_index = 0;
+
+	for(size_t i = 0; i < hotplug->hotplug_count; i++)
+	{
+		const struct joystick_input_attrib *curr_input_attrib = &hotplug->hotplug_registry[i];
+
+		if(joystick_input_requirement_satisfied(input_requirement, curr_input_attrib) < 0){
+			continue;
+		}
+
+		memcpy(&input_attrib[joystick_device_found_index], curr_input_attrib, sizeof(struct joystick_input_attrib));
+		joystick_device_found_index = joystick_device_found_index + 1;
+
+		if(joystick_device_found_index == input_attrib_max){
+			break;
+		}
+	}
+
+	return joystick_device_found_index;
+}
@@ -8,17 +8,22 @@
 #include "joystick_map.h"
 
 
-void joystick_map_create(struct joystick_map * const map, const uint32_t input_count, const uint32_t output_count)
+int joystick_map_create(struct joystick_map * const map, const uint32_t input_count, const uint32_t output_count)
 {
 	assert(map != NULL);
-	assert(input_count <= JOYSTICK_MAP_INPUT_MAX);
-	assert(output_count <= JOYSTICK_MAP_OUTPUT_MAX);
 
 	memset(map, 0, sizeof(struct joystick_map));	
 
+	if(input_count == 0 || input_count > JOYSTICK_MAP_INPUT_MAX
+	|| output_count == 0 || output_count > JOYSTICK_MAP_OUTPUT_MAX)
+	{
+		return -1;
+	}
+
 	map->map_output_count = output_count;
 	map->map_input_count = input_count;
 	
+	return 0;
 }
 
 void joystick_map_destroy(struct joystick_map * const map)
@@ -47,12 +52,19 @@ void joystick_map_transform(struct joystick_map * const map, const uint32_t inpu
 void joystick_map_translate(struct joystick_map * const map, struct joystick_input_value *input_value,  float * const output, const uint32_t output_length)
 {
 	assert(map != NULL);
+	assert(input_value != NULL);
+
+	joystick_map_translate_array(map, input_value->joystick_axis_value, output, output_length);
+}
+
+void joystick_map_translate_array(struct joystick_map * const map, const float *input, float * const output, const uint32_t output_length)
+{
+	assert(map != NULL);
+	assert(input != NULL);
 	assert(output != NULL);
 		
 	assert(output_length == map->map_output_count);
 
-	float *input = input_value->joystick_axis_value;	
-
 	/*
 	 * Matrix vector mul. Ax = b
 	 */
@@ -72,6 +84,90 @@ void joystick_map_translate(struct joystick_map * const map, struct joystick_inp
 	}
 }
 
+void joystick_map_incremental_create(struct joystick_map_incremental * const incremental, const uint32_t refresh)
+{
+	assert(incremental != NULL);
+	assert(refresh > 0);
+
+	memset(incremental, 0, sizeof(struct joystick_map_incremental));
+
+	incremental->incremental_refresh = refresh;
+	incremental->incremental_count = refresh;
+}
+
+void joystick_map_incremental_reset(struct joystick_map_incremental * const incremental)
+{
+	assert(incremental != NULL);
+
+	incremental->incremental_count = incremental->incremental_refresh;
+}
+
+void joystick_map_translate_incremental(struct joystick_map * const map, struct joystick_map_incremental * const incremental, struct joystick_input_value *input_value, float * const output, const uint32_t output_length)
+{
+	assert(map != NULL);
+	assert(incremental != NULL);
+	assert(input_value != NULL);
+	assert(output != NULL);
+
+	assert(output_length == map->map_output_count);
+
+	if(map->map_input_count*map->map_output_count <= JOYSTICK_MAP_INCREMENTAL_SIZE)
+	{
+		joystick_map_translate(map, input_value, output, output_length);
+
+		/* Kept outputs are not updated, recompute them if the map grows. */
+		incremental->incremental_count = incremental->incremental_refresh;
+		return;
+	}
+
+	float *input = input_value->joystick_axis_value;
+	float *previous = incremental->incremental_input;
+	float *o = incremental->incremental_output;
+
+	uint32_t changed = input_value->joystick_axis_changed;
+	if(map->map_input_count < 32){
+		changed &= (1u << map->map_input_count) - 1u;
+	}
+
+	const uint32_t changed_count = (uint32_t)__builtin_popcount(changed);
+
+	if(incremental->incremental_count >= incremental->incremental_refresh
+	|| changed_count*JOYSTICK_MAP_INCREMENTAL_SHARE >= map->map_input_count)
+	{
+		joystick_map_translate(map, input_value, o, output_length);
+		memcpy(previous, input, map->map_input_count*sizeof(float));
+
+		incremental->incremental_count = 0;
+	}
+	else
+	{
+		/*
+		 * O += A_j (x_j - x'_j) for every changed axis j.
+		 */
+
+		while(changed != 0)
+		{
+			const uint32_t j = (uint32_t)__builtin_ctz(changed);
+			changed &= changed - 1u;
+
+			const float delta = input[j] - previous[j];
+			if(delta == 0.0f){
+				continue;
+			}
+
+			previous[j] = input[j];
+
+			for(uint32_t i = 0; i < map->map_output_count; i++){
+				o[i] = o[i] + delta*map->map_matrix[j][i];
+			}
+		}
+
+		incremental->incremental_count++;
+	}
+
+	memcpy(output, o, output_length*sizeof(float));
+}
+
 void joystick_map_print(struct joystick_map * const map, FILE * const output)
 {
 	assert(map != NULL);
@@ -0,0 +1,403 @@
+
+
+#include <assert.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JOYSTICK_MAP_X86 1
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "joystick_map_packed.h"
+
+/* Alignment of the packed matrix, enough for AVX. */
+#define JOYSTICK_MAP_PACKED_ALIGN 32
+
+
+/*
+ * Every kernel computes O = b + x0*A0 + x1*A1 + ... column by column,
+ * in the same order as joystick_map_translate. The full padded stride
+ * is written to output.
+ */
+
+static void joystick_map_kernel_scalar(const float *matrix, const uint32_t stride, const uint32_t input_count, const float *input, float *output)
+{
+	for(uint32_t i = 0; i < stride; i++)
+	{
+		float o_i = matrix[i];
+
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			o_i = o_i + input[j]*matrix[(j + 1)*stride + i];
+		}
+
+		output[i] = o_i;
+	}
+}
+
+#if defined(JOYSTICK_MAP_X86)
+
+static void joystick_map_kernel_sse2(const float *matrix, const uint32_t stride, const uint32_t input_count, const float *input, float *output)
+{
+	for(uint32_t i = 0; i < stride; i += 4)
+	{
+		__m128 o_i = _mm_load_ps(&matrix[i]);
+
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			const __m128 v = _mm_set1_ps(input[j]);
+			const __m128 e = _mm_load_ps(&matrix[(j + 1)*stride + i]);
+			o_i = _mm_add_ps(o_i, _mm_mul_ps(v, e));
+		}
+
+		_mm_store_ps(&output[i], o_i);
+	}
+}
+
+__attribute__((target("avx2")))
+static void joystick_map_kernel_avx2(const float *matrix, const uint32_t stride, const uint32_t input_count, const float *input, float *output)
+{
+	for(uint32_t i = 0; i < stride; i += 8)
+	{
+		__m256 o_i = _mm256_load_ps(&matrix[i]);
+
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			const __m256 v = _mm256_set1_ps(input[j]);
+			const __m256 e = _mm256_load_ps(&matrix[(j + 1)*stride + i]);
+			o_i = _mm256_add_ps(o_i, _mm256_mul_ps(v, e));
+		}
+
+		_mm256_store_ps(&output[i], o_i);
+	}
+}
+
+#endif
+
+#if defined(__ARM_NEON)
+
+static void joystick_map_kernel_neon(const float *matrix, const uint32_t stride, const uint32_t input_count, const float *input, float *output)
+{
+	for(uint32_t i = 0; i < stride; i += 4)
+	{
+		float32x4_t o_i = vld1q_f32(&matrix[i]);
+
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			const float32x4_t v = vdupq_n_f32(input[j]);
+			const float32x4_t e = vld1q_f32(&matrix[(j + 1)*stride + i]);
+			o_i = vaddq_f32(o_i, vmulq_f32(v, e));
+		}
+
+		vst1q_f32(&output[i], o_i);
+	}
+}
+
+#endif
+
+static int joystick_map_kernel_supported(const enum joystick_map_kernel kernel)
+{
+	switch(kernel)
+	{
+		case JOYSTICK_MAP_KERNEL_SCALAR:
+			return 1;
+
+#if defined(JOYSTICK_MAP_X86)
+		case JOYSTICK_MAP_KERNEL_SSE2:
+			return __builtin_cpu_supports("sse2") ? 1 : 0;
+
+		case JOYSTICK_MAP_KERNEL_AVX2:
+			return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+
+#if defined(__ARM_NEON)
+		case JOYSTICK_MAP_KERNEL_NEON:
+			return 1;
+#endif
+
+		default:
+			return 0;
+	}
+}
+
+static enum joystick_map_kernel joystick_map_kernel_best(void)
+{
+	const enum joystick_map_kernel preferred[] = {
+		JOYSTICK_MAP_KERNEL_AVX2,
+		JOYSTICK_MAP_KERNEL_NEON,
+		JOYSTICK_MAP_KERNEL_SSE2,
+	};
+
+	for(size_t i = 0; i < sizeof preferred/sizeof preferred[0]; i++)
+	{
+		if(joystick_map_kernel_supported(preferred[i])){
+			return preferred[i];
+		}
+	}
+
+	return JOYSTICK_MAP_KERNEL_SCALAR;
+}
+
+int joystick_map_pack_kernel(struct joystick_map * const map, struct joystick_map_packed * const packed, const enum joystick_map_kernel kernel)
+{
+	assert(map != NULL);
+	assert(packed != NULL);
+
+	memset(packed, 0, sizeof(struct joystick_map_packed));
+
+	const enum joystick_map_kernel chosen = kernel == JOYSTICK_MAP_KERNEL_AUTO ? joystick_map_kernel_best() : kernel;
+	if(!joystick_map_kernel_supported(chosen)){
+		return -1;
+	}
+
+	const uint32_t stride = (map->map_output_count + JOYSTICK_MAP_PACKED_LANES - 1)/JOYSTICK_MAP_PACKED_LANES*JOYSTICK_MAP_PACKED_LANES;
+	const size_t matrix_size = (size_t)(map->map_input_count + 1)*stride*sizeof(float);
+
+	void *matrix = NULL;
+	if(posix_memalign(&matrix, JOYSTICK_MAP_PACKED_ALIGN, matrix_size) != 0){
+		return -1;
+	}
+
+	/* Padding lanes stay zero. */
+	memset(matrix, 0, matrix_size);
+
+	float *packed_matrix = (float *)matrix;
+
+	memcpy(packed_matrix, map->map_offset, map->map_output_count*sizeof(float));
+
+	for(uint32_t j = 0; j < map->map_input_count; j++){
+		memcpy(&packed_matrix[(j + 1)*stride], map->map_matrix[j], map->map_output_count*sizeof(float));
+	}
+
+	packed->packed_input_count = map->map_input_count;
+	packed->packed_output_count = map->map_output_count;
+	packed->packed_stride = stride;
+	packed->packed_kernel = chosen;
+	packed->packed_matrix = packed_matrix;
+
+	return 0;
+}
+
+int joystick_map_pack(struct joystick_map * const map, struct joystick_map_packed * const packed)
+{
+	return joystick_map_pack_kernel(map, packed, JOYSTICK_MAP_KERNEL_AUTO);
+}
+
+void joystick_map_packed_destroy(struct joystick_map_packed * const packed)
+{
+	assert(packed != NULL);
+
+	free(packed->packed_matrix);
+	packed->packed_matrix = NULL;
+}
+
+/*
+ * Run the kernel of the packed map. Writes the full padded stride.
+ */
+static void joystick_map_packed_run(const struct joystick_map_packed * const packed, const float *input, float *padded)
+{
+	const float *matrix = packed->packed_matrix;
+	const uint32_t stride = packed->packed_stride;
+	const uint32_t input_count = packed->packed_input_count;
+
+	switch(packed->packed_kernel)
+	{
+#if defined(JOYSTICK_MAP_X86)
+		case JOYSTICK_MAP_KERNEL_AVX2:
+			joystick_map_kernel_avx2(matrix, stride, input_count, input, padded);
+			break;
+
+		case JOYSTICK_MAP_KERNEL_SSE2:
+			joystick_map_kernel_sse2(matrix, stride, input_count, input, padded);
+			break;
+#endif
+
+#if defined(__ARM_NEON)
+		case JOYSTICK_MAP_KERNEL_NEON:
+			joystick_map_kernel_neon(matrix, stride, input_count, input, padded);
+			break;
+#endif
+
+		default:
+			joystick_map_kernel_scalar(matrix, stride, input_count, input, padded);
+			break;
+	}
+}
+
+void joystick_map_packed_translate_array(const struct joystick_map_packed * const packed, const float *input, float * const output, const uint32_t output_length)
+{
+	assert(packed != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+	assert(output_length == packed->packed_output_count);
+
+	float padded[JOYSTICK_MAP_OUTPUT_MAX + JOYSTICK_MAP_PACKED_LANES] __attribute__((aligned(JOYSTICK_MAP_PACKED_ALIGN)));
+
+	joystick_map_packed_run(packed, input, padded);
+
+	memcpy(output, padded, output_length*sizeof(float));
+}
+
+void joystick_map_packed_translate(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length)
+{
+	assert(input_value != NULL);
+
+	joystick_map_packed_translate_array(packed, input_value->joystick_axis_value, output, output_length);
+}
+
+void joystick_map_packed_translate_batch(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_values, const size_t frame_count, float * const output)
+{
+	assert(packed != NULL);
+	assert(input_values != NULL || frame_count == 0);
+	assert(output != NULL || frame_count == 0);
+
+	float padded[JOYSTICK_MAP_OUTPUT_MAX + JOYSTICK_MAP_PACKED_LANES] __attribute__((aligned(JOYSTICK_MAP_PACKED_ALIGN)));
+	const uint32_t output_count = packed->packed_output_count;
+
+	for(size_t f = 0; f < frame_count; f++)
+	{
+		joystick_map_packed_run(packed, input_values[f].joystick_axis_value, padded);
+		memcpy(&output[f*output_count], padded, output_count*sizeof(float));
+	}
+}
+
+void joystick_map_packed_translate_batch_soa(const struct joystick_map_packed * const packed, const float *input, const size_t frame_count, float * const output)
+{
+	assert(packed != NULL);
+	assert(input != NULL || frame_count == 0);
+	assert(output != NULL || frame_count == 0);
+
+	/* 
+	 * O = A X + b with frames as columns of X. Frames are handled in 
+	 * blocks that stay in cache, the inner loop runs over contiguous 
+	 * frames so the compiler can vectorize it. Terms are summed in the 
+	 * same order as the single frame path.
+	 */
+	enum { block_size = 64 };
+
+	const float *matrix = packed->packed_matrix;
+	const uint32_t stride = packed->packed_stride;
+	const uint32_t input_count = packed->packed_input_count;
+	const uint32_t output_count = packed->packed_output_count;
+
+	float block[JOYSTICK_MAP_OUTPUT_MAX][block_size];
+
+	for(size_t f_begin = 0; f_begin < frame_count; f_begin += block_size)
+	{
+		const size_t f_count = frame_count - f_begin < block_size ? frame_count - f_begin : block_size;
+
+		for(uint32_t i = 0; i < output_count; i++)
+		{
+			for(size_t f = 0; f < f_count; f++){
+				block[i][f] = matrix[i];
+			}
+		}
+
+		/* Every input row is read once per block. */
+		for(uint32_t j = 0; j < input_count; j++)
+		{
+			const float *column = &matrix[(j + 1)*stride];
+			const float *x = &input[j*frame_count + f_begin];
+
+			for(uint32_t i = 0; i < output_count; i++)
+			{
+				const float e = column[i];
+				for(size_t f = 0; f < f_count; f++){
+					block[i][f] = block[i][f] + x[f]*e;
+				}
+			}
+		}
+
+		for(size_t f = 0; f < f_count; f++)
+		{
+			float *o = &output[(f_begin + f)*output_count];
+			for(uint32_t i = 0; i < output_count; i++){
+				o[i] = block[i][f];
+			}
+		}
+	}
+}
+
+struct joystick_map_batch_task
+{
+	const struct joystick_map_packed *task_packed;
+	const struct joystick_input_value *task_input_values;
+	size_t task_frame_count;
+	float *task_output;
+};
+
+static void *joystick_map_batch_thread(void *arg)
+{
+	struct joystick_map_batch_task *task = (struct joystick_map_batch_task *)arg;
+
+	joystick_map_packed_translate_batch(task->task_packed, task->task_input_values, task->task_frame_count, task->task_output);
+
+	return NULL;
+}
+
+void joystick_map_packed_translate_batch_parallel(const struct joystick_map_packed * const packed, const struct joystick_input_value *input_values, const size_t frame_count, float * const output, const size_t thread_count)
+{
+	assert(packed != NULL);
+	assert(thread_count > 0);
+
+	enum { thread_max = 64 };
+
+	size_t task_count = thread_count < thread_max ? thread_count : thread_max;
+	if(task_count > frame_count){
+		task_count = frame_count;
+	}
+
+	if(task_count <= 1)
+	{
+		joystick_map_packed_translate_batch(packed, input_values, frame_count, output);
+		return;
+	}
+
+	struct joystick_map_batch_task task[thread_max];
+	pthread_t thread[thread_max];
+	int thread_started[thread_max];
+
+	const uint32_t output_count = packed->packed_output_count;
+	size_t frame_begin = 0;
+
+	for(size_t t = 0; t < task_count; t++)
+	{
+		const size_t frame_end = frame_count*(t + 1)/task_count;
+
+		task[t].task_packed = packed;
+		task[t].task_input_values = &input_values[frame_begin];
+		task[t].task_frame_count = frame_end - frame_begin;
+		task[t].task_output = &output[frame_begin*output_count];
+
+		frame_begin = frame_end;
+	}
+
+	/* 
+	 * The calling thread takes the first part. A part whose thread 
+	 * could not be started is done by the calling thread as well. 
+	 */
+	for(size_t t = 1; t < task_count; t++){
+		thread_started[t] = pthread_create(&thread[t], NULL, joystick_map_batch_thread, &task[t]) == 0;
+	}
+
+	joystick_map_batch_thread(&task[0]);
+
+	for(size_t t = 1; t < task_count; t++)
+	{
+		if(thread_started[t]){
+			pthread_join(thread[t], NULL);
+		}else{
+			joystick_map_batch_thread(&task[t]);
+		}
+	}
+}
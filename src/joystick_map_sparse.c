@@ -0,0 +1,181 @@
+#include <assert.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "joystick_map_sparse.h"
+
+
+static uint32_t joystick_map_nonzero_count(const struct joystick_map * const map)
+{
+	uint32_t nonzero_count = 0;
+
+	for(uint32_t j = 0; j < map->map_input_count; j++)
+	{
+		for(uint32_t i = 0; i < map->map_output_count; i++)
+		{
+			if(map->map_matrix[j][i] != 0.0f){
+				nonzero_count++;
+			}
+		}
+	}
+
+	return nonzero_count;
+}
+
+int joystick_map_sparse_create(struct joystick_map * const map, struct joystick_map_sparse * const sparse)
+{
+	assert(map != NULL);
+	assert(sparse != NULL);
+
+	memset(sparse, 0, sizeof(struct joystick_map_sparse));
+
+	const uint32_t output_count = map->map_output_count;
+	const uint32_t nonzero_count = joystick_map_nonzero_count(map);
+
+	/*
+	 * One allocation, floats first so every array is aligned.
+	 */
+	const size_t size = (output_count + nonzero_count)*sizeof(float)
+		+ (output_count + 1)*sizeof(uint16_t)
+		+ nonzero_count*sizeof(uint8_t);
+
+	uint8_t *memory = malloc(size);
+	if(memory == NULL){
+		return -1;
+	}
+
+	sparse->sparse_offset = (float *)memory;
+	sparse->sparse_value = sparse->sparse_offset + output_count;
+	sparse->sparse_row_begin = (uint16_t *)(sparse->sparse_value + nonzero_count);
+	sparse->sparse_column = (uint8_t *)(sparse->sparse_row_begin + output_count + 1);
+
+	memcpy(sparse->sparse_offset, map->map_offset, output_count*sizeof(float));
+
+	uint16_t k = 0;
+	for(uint32_t i = 0; i < output_count; i++)
+	{
+		sparse->sparse_row_begin[i] = k;
+
+		for(uint32_t j = 0; j < map->map_input_count; j++)
+		{
+			const float e = map->map_matrix[j][i];
+			if(e != 0.0f){
+				sparse->sparse_value[k] = e;
+				sparse->sparse_column[k] = (uint8_t)j;
+				k++;
+			}
+		}
+	}
+
+	sparse->sparse_row_begin[output_count] = k;
+
+	sparse->sparse_input_count = map->map_input_count;
+	sparse->sparse_output_count = output_count;
+	sparse->sparse_nonzero_count = nonzero_count;
+
+	return 0;
+}
+
+void joystick_map_sparse_destroy(struct joystick_map_sparse * const sparse)
+{
+	assert(sparse != NULL);
+
+	/* Owns the whole allocation. */
+	free(sparse->sparse_offset);
+	memset(sparse, 0, sizeof(struct joystick_map_sparse));
+}
+
+size_t joystick_map_sparse_size(const struct joystick_map_sparse * const sparse)
+{
+	assert(sparse != NULL);
+
+	return (sparse->sparse_output_count + sparse->sparse_nonzero_count)*sizeof(float)
+		+ (sparse->sparse_output_count + 1)*sizeof(uint16_t)
+		+ sparse->sparse_nonzero_count*sizeof(uint8_t);
+}
+
+void joystick_map_sparse_translate_array(const struct joystick_map_sparse * const sparse, const float *input, float * const output, const uint32_t output_length)
+{
+	assert(sparse != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	assert(output_length == sparse->sparse_output_count);
+
+	const float *value = sparse->sparse_value;
+	const uint16_t *row_begin = sparse->sparse_row_begin;
+	const uint8_t *column = sparse->sparse_column;
+
+	for(uint32_t i = 0; i < output_length; i++)
+	{
+		float o_i = sparse->sparse_offset[i];
+
+		for(uint32_t k = row_begin[i]; k < row_begin[i + 1]; k++)
+		{
+			o_i = o_i + input[column[k]]*value[k];
+		}
+
+		output[i] = o_i;
+	}
+}
+
+void joystick_map_sparse_translate(const struct joystick_map_sparse * const sparse, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length)
+{
+	assert(input_value != NULL);
+
+	joystick_map_sparse_translate_array(sparse, input_value->joystick_axis_value, output, output_length);
+}
+
+int joystick_map_compile(struct joystick_map * const map, struct joystick_map_compiled * const compiled)
+{
+	assert(map != NULL);
+	assert(compiled != NULL);
+
+	memset(compiled, 0, sizeof(struct joystick_map_compiled));
+
+	const uint32_t element_count = map->map_input_count*map->map_output_count;
+
+	if(joystick_map_nonzero_count(map)*JOYSTICK_MAP_SPARSE_RATIO <= element_count)
+	{
+		compiled->compiled_form = JOYSTICK_MAP_FORM_SPARSE;
+		return joystick_map_sparse_create(map, &compiled->compiled_sparse);
+	}
+
+	compiled->compiled_form = JOYSTICK_MAP_FORM_PACKED;
+	return joystick_map_pack(map, &compiled->compiled_packed);
+}
+
+void joystick_map_compiled_destroy(struct joystick_map_compiled * const compiled)
+{
+	assert(compiled != NULL);
+
+	switch(compiled->compiled_form)
+	{
+		case JOYSTICK_MAP_FORM_PACKED:
+			joystick_map_packed_destroy(&compiled->compiled_packed);
+		break;
+
+		case JOYSTICK_MAP_FORM_SPARSE:
+			joystick_map_sparse_destroy(&compiled->compiled_sparse);
+		break;
+	}
+}
+
+void joystick_map_compiled_translate(const struct joystick_map_compiled * const compiled, const struct joystick_input_value *input_value, float * const output, const uint32_t output_length)
+{
+	assert(compiled != NULL);
+
+	switch(compiled->compiled_form)
+	{
+		case JOYSTICK_MAP_FORM_PACKED:
+			joystick_map_packed_translate(&compiled->compiled_packed, input_value, output, output_length);
+		break;
+
+		case JOYSTICK_MAP_FORM_SPARSE:
+			joystick_map_sparse_translate(&compiled->compiled_sparse, input_value, output, output_length);
+		break;
+	}
+}
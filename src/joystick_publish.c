@@ -0,0 +1,66 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_publish.h"
+
+
+void joystick_publish_create(struct joystick_publish *publish)
+{
+	assert(publish != NULL);
+
+	memset(publish, 0, sizeof(struct joystick_publish));
+}
+
+void joystick_publish_write(struct joystick_publish *publish, const struct joystick_input_value *input_value)
+{
+	assert(publish != NULL);
+	assert(input_value != NULL);
+
+	const uint32_t sequence = publish->publish_sequence;
+
+	/* Mark write in progress before any data is touched. */
+	__atomic_store_n(&publish->publish_sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	memcpy(&publish->publish_value, input_value, sizeof(struct joystick_input_value));
+
+	__atomic_store_n(&publish->publish_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+uint32_t joystick_publish_read(const struct joystick_publish *publish, struct joystick_input_value *input_value)
+{
+	assert(publish != NULL);
+	assert(input_value != NULL);
+
+	uint32_t sequence_begin, sequence_end;
+
+	do
+	{
+		sequence_begin = __atomic_load_n(&publish->publish_sequence, __ATOMIC_ACQUIRE);
+		if(sequence_begin & 1){
+			continue;
+		}
+
+		memcpy(input_value, &publish->publish_value, sizeof(struct joystick_input_value));
+
+		/* Order the copy before the second sequence load. */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		sequence_end = __atomic_load_n(&publish->publish_sequence, __ATOMIC_RELAXED);
+
+		if(sequence_begin == sequence_end){
+			break;
+		}
+
+	}while(1);
+
+	return sequence_begin/2;
+}
+
+uint32_t joystick_publish_sequence(const struct joystick_publish *publish)
+{
+	assert(publish != NULL);
+
+	return __atomic_load_n(&publish->publish_sequence, __ATOMIC_ACQUIRE)/2;
+}
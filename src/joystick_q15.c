@@ -0,0 +1,168 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_q15.h"
+
+/* Largest magnitude of a matrix element. */
+#define JOYSTICK_Q15_ELEMENT_MAX ((float)(INT32_MAX >> JOYSTICK_Q15_MATRIX_SHIFT))
+
+
+/*
+ * Round to nearest, float only used when the map is converted.
+ */
+static int32_t joystick_q15_round(float value)
+{
+	return (int32_t)(value < 0.0f ? value - 0.5f : value + 0.5f);
+}
+
+int joystick_device_poll_q15(struct joystick_device *device, struct joystick_input_value_q15 *input_value)
+{
+	assert(device != NULL);
+	assert(input_value != NULL);
+
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	int event_count = joystick_device_read(device, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE);
+	if(event_count <= 0){
+		return event_count;
+	}
+
+	joystick_input_value_q15_clear_changed(input_value);
+	joystick_device_decode_q15(device, js_event_buffer, (size_t)event_count, input_value);
+
+	return 1;
+}
+
+void joystick_device_decode_q15(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_input_value_q15 *input_value)
+{
+	assert(device != NULL);
+	assert(events != NULL);
+	assert(input_value != NULL);
+
+	/* Larger devices are only decoded in part. */
+	const uint8_t joystick_axis_count = device->input_attrib.joystick_axis_count < JOYSTICK_AXIS_MAX ? device->input_attrib.joystick_axis_count : JOYSTICK_AXIS_MAX;
+	const uint8_t joystick_button_count = device->input_attrib.joystick_button_count < JOYSTICK_BUTTON_MAX ? device->input_attrib.joystick_button_count : JOYSTICK_BUTTON_MAX;
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		const uint8_t number = events[i].number;
+
+		switch(events[i].type & ~JS_EVENT_INIT)
+		{
+			case JS_EVENT_AXIS:
+				if(number < joystick_axis_count){
+					input_value->joystick_axis_value[number] = events[i].value;
+					input_value->joystick_axis_changed |= 1u << number;
+					input_value->joystick_event_time = events[i].time;
+				}
+			break;
+
+			case JS_EVENT_BUTTON:
+				if(number < joystick_button_count){
+					const uint32_t bit = 1u << number;
+
+					/* INIT events report the state, not a press or release. */
+					if(!(events[i].type & JS_EVENT_INIT) && (events[i].value != 0) != (input_value->joystick_button_value[number] != 0)){
+						if(events[i].value != 0){
+							input_value->joystick_button_pressed |= bit;
+						}
+						else{
+							input_value->joystick_button_released |= bit;
+						}
+
+						input_value->joystick_button_changed |= bit;
+					}
+
+					input_value->joystick_button_value[number] = events[i].value;
+					input_value->joystick_event_time = events[i].time;
+				}
+			break;
+		}
+	}
+}
+
+void joystick_input_value_q15_clear_changed(struct joystick_input_value_q15 *input_value)
+{
+	assert(input_value != NULL);
+
+	input_value->joystick_axis_changed = 0;
+	input_value->joystick_button_pressed = 0;
+	input_value->joystick_button_released = 0;
+	input_value->joystick_button_changed = 0;
+}
+
+int joystick_map_q15_create(const struct joystick_map * const map, struct joystick_map_q15 * const map_q15)
+{
+	assert(map != NULL);
+	assert(map_q15 != NULL);
+
+	memset(map_q15, 0, sizeof(struct joystick_map_q15));
+
+	for(uint32_t j = 0; j < map->map_input_count; j++)
+	{
+		for(uint32_t i = 0; i < map->map_output_count; i++)
+		{
+			const float e = map->map_matrix[j][i];
+			if(e >= JOYSTICK_Q15_ELEMENT_MAX || e <= -JOYSTICK_Q15_ELEMENT_MAX){
+				return -1;
+			}
+
+			map_q15->q15_matrix[j][i] = joystick_q15_round(e*(float)(1 << JOYSTICK_Q15_MATRIX_SHIFT));
+		}
+	}
+
+	for(uint32_t i = 0; i < map->map_output_count; i++)
+	{
+		const float b = map->map_offset[i];
+		if(b >= JOYSTICK_Q15_ELEMENT_MAX || b <= -JOYSTICK_Q15_ELEMENT_MAX){
+			return -1;
+		}
+
+		map_q15->q15_offset[i] = joystick_q15_round(b*(float)INT16_MAX);
+	}
+
+	map_q15->q15_input_count = map->map_input_count;
+	map_q15->q15_output_count = map->map_output_count;
+
+	return 0;
+}
+
+void joystick_map_q15_translate_array(const struct joystick_map_q15 * const map_q15, const int16_t *input, int16_t * const output, const uint32_t output_length)
+{
+	assert(map_q15 != NULL);
+	assert(input != NULL);
+	assert(output != NULL);
+
+	assert(output_length == map_q15->q15_output_count);
+
+	for(uint32_t i = 0; i < output_length; i++)
+	{
+		/* |x*e| < 2^46, 64 of them can not overflow. */
+		int64_t o_i = (int64_t)map_q15->q15_offset[i]*((int64_t)1 << JOYSTICK_Q15_MATRIX_SHIFT);
+
+		for(uint32_t j = 0; j < map_q15->q15_input_count; j++)
+		{
+			o_i += (int64_t)input[j]*map_q15->q15_matrix[j][i];
+		}
+
+		/* Round to nearest and saturate. */
+		o_i = (o_i + ((int64_t)1 << (JOYSTICK_Q15_MATRIX_SHIFT - 1))) >> JOYSTICK_Q15_MATRIX_SHIFT;
+
+		if(o_i > INT16_MAX){
+			o_i = INT16_MAX;
+		}
+		else if(o_i < -INT16_MAX){
+			o_i = -INT16_MAX;
+		}
+
+		output[i] = (int16_t)o_i;
+	}
+}
+
+void joystick_map_q15_translate(const struct joystick_map_q15 * const map_q15, const struct joystick_input_value_q15 *input_value, int16_t * const output, const uint32_t output_length)
+{
+	assert(input_value != NULL);
+
+	joystick_map_q15_translate_array(map_q15, input_value->joystick_axis_value, output, output_length);
+}
@@ -0,0 +1,141 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include "joystick_reader.h"
+
+
+static void *joystick_reader_thread(void *arg)
+{
+	struct joystick_reader *reader = (struct joystick_reader *)arg;
+	struct joystick_device *device = reader->reader_device;
+
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+
+	while(__atomic_load_n(&reader->reader_stop, __ATOMIC_ACQUIRE) == 0)
+	{
+		const int connected = joystick_device_is_open(device) > 0;
+		__atomic_store_n(&reader->reader_connected, connected, __ATOMIC_RELEASE);
+
+		uint64_t tag;
+		int timeout_ms = connected ? -1 : JOYSTICK_READER_REOPEN_INTERVAL_MS;
+		if(joystick_wait_poll(&reader->reader_wait, &tag, 1, timeout_ms) < 0){
+			break;
+		}
+
+		if(!connected)
+		{
+			if(joystick_device_reopen(device) > 0){
+				if(joystick_wait_add_device(&reader->reader_wait, device, 0) < 0){
+					joystick_device_close(device);
+				}
+			}
+			continue;
+		}
+
+		/*
+		 * Empty the kernel queue completely so it can not
+		 * overflow while the consumer is stalled.
+		 */
+		int event_count;
+		while((event_count = joystick_device_read(device, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE)) > 0){
+			joystick_ring_push(&reader->reader_ring, js_event_buffer, (size_t)event_count);
+		}
+	}
+
+	return NULL;
+}
+
+int joystick_reader_start(struct joystick_reader *reader, struct joystick_device *device)
+{
+	assert(reader != NULL);
+	assert(device != NULL);
+
+	joystick_ring_create(&reader->reader_ring);
+
+	reader->reader_device = device;
+	reader->reader_stop = 0;
+	reader->reader_connected = joystick_device_is_open(device) > 0;
+
+	if(joystick_wait_create(&reader->reader_wait) < 0){
+		return -1;
+	}
+
+	if(reader->reader_connected){
+		if(joystick_wait_add_device(&reader->reader_wait, device, 0) < 0){
+			joystick_wait_destroy(&reader->reader_wait);
+			return -1;
+		}
+	}
+
+	if(pthread_create(&reader->reader_thread, NULL, joystick_reader_thread, reader) != 0){
+		joystick_wait_destroy(&reader->reader_wait);
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_reader_stop(struct joystick_reader *reader)
+{
+	assert(reader != NULL);
+
+	__atomic_store_n(&reader->reader_stop, 1, __ATOMIC_RELEASE);
+
+	int result = joystick_wait_wakeup(&reader->reader_wait);
+	if(result < 0){
+		return -1;
+	}
+
+	if(pthread_join(reader->reader_thread, NULL) != 0){
+		return -1;
+	}
+
+	return joystick_wait_destroy(&reader->reader_wait);
+}
+
+size_t joystick_reader_drain(struct joystick_reader *reader, struct js_event *events, size_t event_max)
+{
+	assert(reader != NULL);
+
+	return joystick_ring_pop(&reader->reader_ring, events, event_max);
+}
+
+int joystick_reader_drain_value(struct joystick_reader *reader, struct joystick_input_value *input_value)
+{
+	assert(reader != NULL);
+	assert(input_value != NULL);
+
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	int result = 0;
+
+	size_t event_count;
+	while((event_count = joystick_ring_pop(&reader->reader_ring, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE)) > 0)
+	{
+		if(result == 0){
+			joystick_input_value_clear_changed(input_value);
+		}
+
+		joystick_device_decode(reader->reader_device, js_event_buffer, event_count, input_value);
+		result = 1;
+	}
+
+	return result;
+}
+
+int joystick_reader_is_connected(struct joystick_reader *reader)
+{
+	assert(reader != NULL);
+
+	return __atomic_load_n(&reader->reader_connected, __ATOMIC_ACQUIRE) ? 1 : -1;
+}
+
+uint32_t joystick_reader_dropped(struct joystick_reader *reader)
+{
+	assert(reader != NULL);
+
+	return joystick_ring_dropped(&reader->reader_ring);
+}
@@ -0,0 +1,71 @@
+#include <assert.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "joystick_record.h"
+
+
+int joystick_record_create(struct joystick_record *record, const char *path, const struct joystick_input_attrib *input_attrib)
+{
+	assert(record != NULL);
+	assert(path != NULL);
+	assert(input_attrib != NULL);
+
+	memset(record, 0, sizeof(struct joystick_record));
+
+	record->record_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+	if(record->record_fd < 0){
+		return -1;
+	}
+
+	struct joystick_record_header header;
+	memset(&header, 0, sizeof header);
+
+	header.header_magic = JOYSTICK_RECORD_MAGIC;
+	header.header_version = JOYSTICK_RECORD_VERSION;
+	header.header_axis_count = input_attrib->joystick_axis_count;
+	header.header_button_count = input_attrib->joystick_button_count;
+	memcpy(header.header_name, input_attrib->joystick_name, sizeof header.header_name - 1);
+
+	if(write(record->record_fd, &header, sizeof header) != (ssize_t)sizeof header){
+		close(record->record_fd);
+		record->record_fd = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_record_write(struct joystick_record *record, const struct js_event *events, size_t event_count)
+{
+	assert(record != NULL);
+	assert(events != NULL || event_count == 0);
+
+	const size_t size = event_count*sizeof(struct js_event);
+
+	if(record->record_failed || write(record->record_fd, events, size) != (ssize_t)size){
+		record->record_failed = 1;
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_record_close(struct joystick_record *record)
+{
+	assert(record != NULL);
+
+	int result = record->record_failed ? -1 : 0;
+
+	if(close(record->record_fd) < 0){
+		result = -1;
+	}
+
+	record->record_fd = -1;
+
+	return result;
+}
+
@@ -0,0 +1,83 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_ring.h"
+
+#define JOYSTICK_RING_MASK (JOYSTICK_RING_SIZE - 1)
+
+
+void joystick_ring_create(struct joystick_ring *ring)
+{
+	assert(ring != NULL);
+	assert((JOYSTICK_RING_SIZE & JOYSTICK_RING_MASK) == 0);
+
+	memset(ring, 0, sizeof(struct joystick_ring));
+}
+
+size_t joystick_ring_push(struct joystick_ring *ring, const struct js_event *events, size_t event_count)
+{
+	assert(ring != NULL);
+	assert(events != NULL);
+
+	/*
+	 * Indices run freely and wrap at UINT32_MAX, the difference
+	 * head - tail is always the number of events in the ring.
+	 */
+	const uint32_t head = ring->ring_head;
+	uint32_t free_count = JOYSTICK_RING_SIZE - (head - ring->ring_tail_cache);
+
+	if(free_count < event_count)
+	{
+		ring->ring_tail_cache = __atomic_load_n(&ring->ring_tail, __ATOMIC_ACQUIRE);
+		free_count = JOYSTICK_RING_SIZE - (head - ring->ring_tail_cache);
+	}
+
+	const size_t push_count = event_count < free_count ? event_count : free_count;
+
+	for(size_t i = 0; i < push_count; i++){
+		ring->ring_event[(head + (uint32_t)i) & JOYSTICK_RING_MASK] = events[i];
+	}
+
+	__atomic_store_n(&ring->ring_head, head + (uint32_t)push_count, __ATOMIC_RELEASE);
+
+	if(push_count < event_count){
+		const uint32_t dropped = (uint32_t)(event_count - push_count);
+		__atomic_store_n(&ring->ring_dropped, ring->ring_dropped + dropped, __ATOMIC_RELAXED);
+	}
+
+	return push_count;
+}
+
+size_t joystick_ring_pop(struct joystick_ring *ring, struct js_event *events, size_t event_max)
+{
+	assert(ring != NULL);
+	assert(events != NULL);
+
+	const uint32_t tail = ring->ring_tail;
+	uint32_t used_count = ring->ring_head_cache - tail;
+
+	if(used_count < event_max)
+	{
+		ring->ring_head_cache = __atomic_load_n(&ring->ring_head, __ATOMIC_ACQUIRE);
+		used_count = ring->ring_head_cache - tail;
+	}
+
+	const size_t pop_count = event_max < used_count ? event_max : used_count;
+
+	for(size_t i = 0; i < pop_count; i++){
+		events[i] = ring->ring_event[(tail + (uint32_t)i) & JOYSTICK_RING_MASK];
+	}
+
+	__atomic_store_n(&ring->ring_tail, tail + (uint32_t)pop_count, __ATOMIC_RELEASE);
+
+	return pop_count;
+}
+
+uint32_t joystick_ring_dropped(struct joystick_ring *ring)
+{
+	assert(ring != NULL);
+
+	return __atomic_load_n(&ring->ring_dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,202 @@
+/* memfd_create */
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "joystick_shm.h"
+
+
+static int joystick_shm_map(struct joystick_shm *shm, int fd)
+{
+	struct stat stat_buffer;
+	if(fstat(fd, &stat_buffer) < 0){
+		return -1;
+	}
+
+	if((size_t)stat_buffer.st_size < sizeof(struct joystick_shm_region)){
+		return -1;
+	}
+
+	void *region = mmap(NULL, sizeof(struct joystick_shm_region), PROT_READ, MAP_SHARED, fd, 0);
+	if(region == MAP_FAILED){
+		return -1;
+	}
+
+	struct joystick_shm_region *shm_region = (struct joystick_shm_region *)region;
+
+	if(__atomic_load_n(&shm_region->region_magic, __ATOMIC_ACQUIRE) != JOYSTICK_SHM_MAGIC
+	|| shm_region->region_version != JOYSTICK_SHM_VERSION
+	|| shm_region->region_size != sizeof(struct joystick_shm_region))
+	{
+		munmap(region, sizeof(struct joystick_shm_region));
+		return -1;
+	}
+
+	shm->shm_fd = fd;
+	shm->shm_owner = 0;
+	shm->shm_region = shm_region;
+
+	return 0;
+}
+
+int joystick_shm_create(struct joystick_shm *shm, const char *name, const struct joystick_input_attrib *input_attrib)
+{
+	assert(shm != NULL);
+	assert(input_attrib != NULL);
+
+	memset(shm, 0, sizeof(struct joystick_shm));
+	shm->shm_fd = -1;
+
+	int fd = -1;
+
+	if(name == NULL)
+	{
+		fd = memfd_create("joystick", MFD_CLOEXEC);
+	}
+	else
+	{
+		if(strlen(name) >= sizeof shm->shm_name){
+			return -1;
+		}
+
+		/* Never take over a region another owner may still be writing. */
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+	}
+
+	if(fd < 0){
+		return -1;
+	}
+
+	if(ftruncate(fd, (off_t)sizeof(struct joystick_shm_region)) < 0){
+		goto exit;
+	}
+
+	void *region = mmap(NULL, sizeof(struct joystick_shm_region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(region == MAP_FAILED){
+		goto exit;
+	}
+
+	struct joystick_shm_region *shm_region = (struct joystick_shm_region *)region;
+
+	shm_region->region_version = JOYSTICK_SHM_VERSION;
+	shm_region->region_size = sizeof(struct joystick_shm_region);
+	memcpy(&shm_region->region_input_attrib, input_attrib, sizeof(struct joystick_input_attrib));
+	joystick_publish_create(&shm_region->region_publish);
+
+	__atomic_store_n(&shm_region->region_magic, JOYSTICK_SHM_MAGIC, __ATOMIC_RELEASE);
+
+	shm->shm_fd = fd;
+	shm->shm_owner = 1;
+	shm->shm_region = shm_region;
+
+	if(name != NULL){
+		strcpy(shm->shm_name, name);
+	}
+
+	return 0;
+
+exit:
+	close(fd);
+	if(name != NULL){
+		shm_unlink(name);
+	}
+	return -1;
+}
+
+int joystick_shm_attach(struct joystick_shm *shm, const char *name)
+{
+	assert(shm != NULL);
+	assert(name != NULL);
+
+	memset(shm, 0, sizeof(struct joystick_shm));
+	shm->shm_fd = -1;
+
+	int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+	if(fd < 0){
+		return -1;
+	}
+
+	if(joystick_shm_map(shm, fd) < 0){
+		close(fd);
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_shm_attach_fd(struct joystick_shm *shm, int fd)
+{
+	assert(shm != NULL);
+
+	memset(shm, 0, sizeof(struct joystick_shm));
+	shm->shm_fd = -1;
+
+	int fd_dup = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if(fd_dup < 0){
+		return -1;
+	}
+
+	if(joystick_shm_map(shm, fd_dup) < 0){
+		close(fd_dup);
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_shm_destroy(struct joystick_shm *shm)
+{
+	assert(shm != NULL);
+
+	int result = 0;
+
+	if(shm->shm_region != NULL){
+		result = munmap(shm->shm_region, sizeof(struct joystick_shm_region));
+		shm->shm_region = NULL;
+	}
+
+	if(shm->shm_fd >= 0){
+		close(shm->shm_fd);
+		shm->shm_fd = -1;
+	}
+
+	if(shm->shm_owner && shm->shm_name[0] != '\0'){
+		if(shm_unlink(shm->shm_name) < 0){
+			result = -1;
+		}
+	}
+
+	return result < 0 ? -1 : 0;
+}
+
+void joystick_shm_write(struct joystick_shm *shm, const struct joystick_input_value *input_value)
+{
+	assert(shm != NULL);
+	assert(shm->shm_owner);
+
+	joystick_publish_write(&shm->shm_region->region_publish, input_value);
+}
+
+uint32_t joystick_shm_read(const struct joystick_shm *shm, struct joystick_input_value *input_value)
+{
+	assert(shm != NULL);
+	assert(shm->shm_region != NULL);
+
+	return joystick_publish_read(&shm->shm_region->region_publish, input_value);
+}
+
+const struct joystick_input_attrib *joystick_shm_input_attrib(const struct joystick_shm *shm)
+{
+	assert(shm != NULL);
+	assert(shm->shm_region != NULL);
+
+	return &shm->shm_region->region_input_attrib;
+}
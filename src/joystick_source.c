@@ -0,0 +1,568 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "joystick_record.h"
+#include "joystick_source.h"
+
+/* Writes up to PIPE_BUF are atomic, so the device never reads half an event. */
+#define JOYSTICK_SOURCE_CHUNK (PIPE_BUF/sizeof(struct js_event))
+
+/* Rate used for event times when the generator is not paced. */
+#define JOYSTICK_SOURCE_NOMINAL_RATE 1000
+
+#define JOYSTICK_SOURCE_PI 3.14159265358979323846
+
+
+struct joystick_source_generator
+{
+	uint64_t generator_index;
+	uint32_t generator_random;
+
+	/* Init events left to write, axes first. */
+	uint32_t generator_init;
+
+	uint8_t generator_button[JOYSTICK_DEVICE_BUTTON_MAX + 1];
+
+	/* Recorded events, replay only. */
+	const struct js_event *generator_replay;
+	uint64_t generator_replay_count;
+};
+
+
+void joystick_source_config_default(struct joystick_source_config *config, enum joystick_source_type type)
+{
+	assert(config != NULL);
+
+	memset(config, 0, sizeof(struct joystick_source_config));
+
+	config->config_type = type;
+	config->config_input_attrib.joystick_axis_count = 6;
+	config->config_input_attrib.joystick_button_count = 17;
+
+	const char name[] = "Synthetic joystick";
+	memcpy(config->config_input_attrib.joystick_name, name, sizeof name);
+
+	config->config_pattern = JOYSTICK_SOURCE_SINE;
+	config->config_rate = 1000;
+	config->config_period_ms = 1000;
+	config->config_burst = 64;
+	config->config_seed = 1;
+}
+
+
+static uint32_t joystick_source_random(struct joystick_source_generator *generator)
+{
+	/* xorshift32 */
+	uint32_t x = generator->generator_random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	generator->generator_random = x;
+
+	return x;
+}
+
+/*
+ * Event time of the nth pattern event in nanoseconds.
+ */
+static uint64_t joystick_source_time(const struct joystick_source_config *config, uint64_t index)
+{
+	const uint64_t rate = config->config_rate != 0 ? config->config_rate : JOYSTICK_SOURCE_NOMINAL_RATE;
+
+	/*
+	 * A burst is written at the time of its first event. Bursts follow
+	 * each other by the time their events take at the rate, plus idle.
+	 */
+	if(config->config_pattern == JOYSTICK_SOURCE_BURST)
+	{
+		const uint64_t burst = index/config->config_burst;
+		return burst*(config->config_burst*UINT64_C(1000000000)/rate + config->config_period_ms*UINT64_C(1000000));
+	}
+
+	return index*UINT64_C(1000000000)/rate;
+}
+
+/*
+ * Time the next event is due at in nanoseconds from the start, 0 if at once.
+ *
+ * @return Returns 0 on success. -1 if the source has ended.
+ */
+static int joystick_source_due(const struct joystick_source_config *config, const struct joystick_source_generator *generator, uint64_t *time_ns)
+{
+	const uint64_t index = generator->generator_index;
+
+	*time_ns = 0;
+
+	if(generator->generator_init > 0){
+		return 0;
+	}
+
+	if(config->config_type == JOYSTICK_SOURCE_REPLAY)
+	{
+		if(index >= generator->generator_replay_count){
+			return -1;
+		}
+
+		if(config->config_realtime){
+			const uint32_t time_ms = generator->generator_replay[index].time - generator->generator_replay[0].time;
+			*time_ns = (uint64_t)time_ms*UINT64_C(1000000);
+		}
+
+		return 0;
+	}
+
+	if(config->config_event_count != 0 && index >= config->config_event_count){
+		return -1;
+	}
+
+	if(config->config_rate != 0){
+		*time_ns = joystick_source_time(config, index);
+	}
+
+	return 0;
+}
+
+static void joystick_source_generate(const struct joystick_source_config *config, struct joystick_source_generator *generator, struct js_event *event)
+{
+	const uint32_t axis_count = config->config_input_attrib.joystick_axis_count;
+	const uint32_t button_count = config->config_input_attrib.joystick_button_count;
+
+	if(config->config_type == JOYSTICK_SOURCE_REPLAY)
+	{
+		*event = generator->generator_replay[generator->generator_index++];
+		return;
+	}
+
+	if(generator->generator_init > 0)
+	{
+		const uint32_t init = axis_count + button_count - generator->generator_init--;
+
+		event->time = 0;
+		event->value = 0;
+		event->type = JS_EVENT_INIT | (init < axis_count ? JS_EVENT_AXIS : JS_EVENT_BUTTON);
+		event->number = (uint8_t)(init < axis_count ? init : init - axis_count);
+		return;
+	}
+
+	const uint64_t index = generator->generator_index++;
+	const uint64_t time_ns = joystick_source_time(config, index);
+
+	event->time = (uint32_t)(time_ns/1000000);
+
+	uint32_t button;
+
+	switch(config->config_pattern)
+	{
+		case JOYSTICK_SOURCE_SINE:
+		{
+			const uint32_t axis = (uint32_t)(index%axis_count);
+			const double phase = (double)time_ns/((double)config->config_period_ms*1e6) + (double)axis/(double)axis_count;
+
+			event->type = JS_EVENT_AXIS;
+			event->number = (uint8_t)axis;
+			event->value = (int16_t)lrint(sin(2.0*JOYSTICK_SOURCE_PI*phase)*32767.0);
+			return;
+		}
+
+		case JOYSTICK_SOURCE_BUTTON_STORM:
+			button = (uint32_t)(index%button_count);
+			break;
+
+		case JOYSTICK_SOURCE_BURST:
+		{
+			const uint32_t random = joystick_source_random(generator);
+			const uint32_t number = random%(axis_count + button_count);
+
+			if(number < axis_count)
+			{
+				event->type = JS_EVENT_AXIS;
+				event->number = (uint8_t)number;
+				event->value = (int16_t)(random >> 16);
+				return;
+			}
+
+			button = number - axis_count;
+			break;
+		}
+
+		default:
+			assert(0);
+			return;
+	}
+
+	generator->generator_button[button] ^= 1;
+
+	event->type = JS_EVENT_BUTTON;
+	event->number = (uint8_t)button;
+	event->value = generator->generator_button[button];
+}
+
+
+/*
+ * Wait until the fd is ready, the timeout or the source is stopped.
+ *
+ * @param timeout Timeout, NULL for none.
+ *
+ * @return Returns 0 if ready or timed out. -1 if stopped.
+ */
+static int joystick_source_wait(struct joystick_source *source, short events, const struct timespec *timeout)
+{
+	struct pollfd poll_fd[2] = {
+		{.fd = source->source_stop_fd, .events = POLLIN},
+		{.fd = source->source_fd, .events = events},
+	};
+
+	int result;
+	do{
+		result = ppoll(poll_fd, events != 0 ? 2 : 1, timeout, NULL);
+	}while(result < 0 && errno == EINTR);
+
+	return result < 0 || (poll_fd[0].revents & POLLIN) ? -1 : 0;
+}
+
+static uint64_t joystick_source_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec*UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+}
+
+static void *joystick_source_thread(void *arg)
+{
+	struct joystick_source *source = (struct joystick_source *)arg;
+	const struct joystick_source_config *config = &source->source_config;
+
+	/* Writing to a closed device gives EPIPE instead of killing the process. */
+	sigset_t signal_set;
+	sigfillset(&signal_set);
+	pthread_sigmask(SIG_BLOCK, &signal_set, NULL);
+
+	struct joystick_source_generator generator;
+	memset(&generator, 0, sizeof generator);
+	generator.generator_random = config->config_seed != 0 ? config->config_seed : 1;
+
+	if(config->config_type == JOYSTICK_SOURCE_REPLAY)
+	{
+		/* A recording holds the INIT events joydev wrote when it was made. */
+		generator.generator_replay = (const struct js_event *)(const void *)(source->source_replay + sizeof(struct joystick_record_header));
+		generator.generator_replay_count = (source->source_replay_size - sizeof(struct joystick_record_header))/sizeof(struct js_event);
+	}
+	else
+	{
+		generator.generator_init = (uint32_t)config->config_input_attrib.joystick_axis_count + config->config_input_attrib.joystick_button_count;
+	}
+
+	struct js_event events[JOYSTICK_SOURCE_CHUNK];
+	size_t event_count = 0;
+
+	const uint64_t start = joystick_source_now();
+
+	for(;;)
+	{
+		/* Fill with the events that are due. */
+		const uint64_t elapsed = joystick_source_now() - start;
+
+		uint64_t due = 0;
+		int ended = 0;
+
+		while(event_count < JOYSTICK_SOURCE_CHUNK)
+		{
+			if(joystick_source_due(config, &generator, &due) < 0){
+				ended = 1;
+				break;
+			}
+
+			if(due > elapsed){
+				break;
+			}
+
+			joystick_source_generate(config, &generator, &events[event_count++]);
+		}
+
+		if(event_count == 0)
+		{
+			if(ended){
+				break;
+			}
+
+			/* Sleep until the next event is due. */
+			const uint64_t sleep = due - elapsed;
+			const struct timespec timeout = {
+				.tv_sec = (time_t)(sleep/UINT64_C(1000000000)),
+				.tv_nsec = (long)(sleep%UINT64_C(1000000000)),
+			};
+
+			if(joystick_source_wait(source, 0, &timeout) < 0){
+				break;
+			}
+
+			continue;
+		}
+
+		ssize_t bytes_written = write(source->source_fd, events, event_count*sizeof(struct js_event));
+		if(bytes_written < 0)
+		{
+			if(errno == EINTR){
+				continue;
+			}
+
+			if(errno == EAGAIN && joystick_source_wait(source, POLLOUT, NULL) == 0){
+				continue;
+			}
+
+			/* Stopped or device closed. */
+			break;
+		}
+
+		event_count = 0;
+	}
+
+	/* End of the pattern or recording reads as disconnected. */
+	close(source->source_fd);
+	source->source_fd = -1;
+
+	return NULL;
+}
+
+
+/*
+ * Map a recording and take the device attributes from its header.
+ *
+ * @return Returns 0 on success. -1 on failure or if the file is not a recording.
+ */
+static int joystick_source_map(struct joystick_source *source, const char *path, struct joystick_input_attrib *input_attrib)
+{
+	/* +1 for NULL */
+	const size_t path_length = strlen(path) + 1;
+	if(path_length > sizeof input_attrib->joystick_device_path){
+		return -1;
+	}
+
+	int file_fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(file_fd < 0){
+		return -1;
+	}
+
+	struct stat stat_buffer;
+	if(fstat(file_fd, &stat_buffer) < 0 || (size_t)stat_buffer.st_size < sizeof(struct joystick_record_header)){
+		close(file_fd);
+		return -1;
+	}
+
+	const size_t size = (size_t)stat_buffer.st_size;
+
+	void *memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file_fd, 0);
+	close(file_fd);
+
+	if(memory == MAP_FAILED){
+		return -1;
+	}
+
+	const struct joystick_record_header *header = (const struct joystick_record_header *)memory;
+	if(header->header_magic != JOYSTICK_RECORD_MAGIC || header->header_version != JOYSTICK_RECORD_VERSION){
+		munmap(memory, size);
+		return -1;
+	}
+
+	/* Events are read in order, from start to end. */
+	madvise(memory, size, MADV_SEQUENTIAL);
+
+	memset(input_attrib, 0, sizeof(struct joystick_input_attrib));
+	memcpy(input_attrib->joystick_device_path, path, path_length);
+	memcpy(input_attrib->joystick_name, header->header_name, sizeof input_attrib->joystick_name - 1);
+	input_attrib->joystick_axis_count = header->header_axis_count;
+	input_attrib->joystick_button_count = header->header_button_count;
+
+	source->source_replay = (const uint8_t *)memory;
+	source->source_replay_size = size;
+
+	return 0;
+}
+
+int joystick_source_open(struct joystick_source *source, struct joystick_device *device, const struct joystick_source_config *config)
+{
+	assert(source != NULL);
+	assert(device != NULL);
+	assert(config != NULL);
+
+	memset(source, 0, sizeof(struct joystick_source));
+	source->source_type = config->config_type;
+	source->source_fd = -1;
+	source->source_stop_fd = -1;
+	source->source_config = *config;
+
+	if(config->config_type == JOYSTICK_SOURCE_JOYDEV)
+	{
+		assert(config->config_device_path != NULL);
+
+		return joystick_device_open(device, config->config_device_path) < 0 ? -1 : 0;
+	}
+
+	assert(config->config_type == JOYSTICK_SOURCE_STREAM || config->config_type == JOYSTICK_SOURCE_GENERATOR || config->config_type == JOYSTICK_SOURCE_REPLAY);
+
+	const int threaded = config->config_type != JOYSTICK_SOURCE_STREAM;
+
+	struct joystick_input_attrib input_attrib_buffer;
+	const struct joystick_input_attrib *input_attrib = &config->config_input_attrib;
+
+	if(config->config_type == JOYSTICK_SOURCE_REPLAY)
+	{
+		assert(config->config_device_path != NULL);
+
+		if(joystick_source_map(source, config->config_device_path, &input_attrib_buffer) < 0){
+			return -1;
+		}
+
+		input_attrib = &input_attrib_buffer;
+	}
+
+	if(config->config_type == JOYSTICK_SOURCE_GENERATOR)
+	{
+		if(config->config_pattern == JOYSTICK_SOURCE_SINE && (input_attrib->joystick_axis_count == 0 || config->config_period_ms == 0)){
+			return -1;
+		}
+
+		if(config->config_pattern == JOYSTICK_SOURCE_BUTTON_STORM && input_attrib->joystick_button_count == 0){
+			return -1;
+		}
+
+		if(config->config_pattern == JOYSTICK_SOURCE_BURST && (config->config_burst == 0 || input_attrib->joystick_axis_count + input_attrib->joystick_button_count == 0)){
+			return -1;
+		}
+	}
+
+	int pipe_fd[2];
+	if(pipe2(pipe_fd, O_CLOEXEC) < 0){
+		goto exit_replay;
+	}
+
+	/* The stream writer blocks on a full pipe, the writer thread waits for it with poll. */
+	fcntl(pipe_fd[0], F_SETFL, O_NONBLOCK);
+	if(threaded){
+		fcntl(pipe_fd[1], F_SETFL, O_NONBLOCK);
+	}
+
+	source->source_fd = pipe_fd[1];
+
+	if(threaded)
+	{
+		source->source_stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if(source->source_stop_fd < 0){
+			goto exit;
+		}
+
+		if(pthread_create(&source->source_thread, NULL, joystick_source_thread, source) != 0){
+			close(source->source_stop_fd);
+			source->source_stop_fd = -1;
+			goto exit;
+		}
+	}
+
+	joystick_device_create(device, pipe_fd[0], input_attrib);
+
+	return 0;
+
+exit:
+	close(pipe_fd[0]);
+	close(pipe_fd[1]);
+	source->source_fd = -1;
+
+exit_replay:
+	if(source->source_replay != NULL){
+		munmap((void *)source->source_replay, source->source_replay_size);
+		source->source_replay = NULL;
+	}
+
+	return -1;
+}
+
+int joystick_source_write(struct joystick_source *source, const struct js_event *events, size_t event_count)
+{
+	assert(source != NULL);
+	assert(source->source_type == JOYSTICK_SOURCE_STREAM);
+	assert(events != NULL || event_count == 0);
+
+	/* Writing to a closed device gives EPIPE instead of killing the process. */
+	sigset_t pipe_set, old_set, pending_set;
+	sigemptyset(&pipe_set);
+	sigaddset(&pipe_set, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+	sigpending(&pending_set);
+	const int pipe_pending = sigismember(&pending_set, SIGPIPE);
+
+	int result = 0;
+
+	while(event_count > 0)
+	{
+		const size_t chunk = event_count < JOYSTICK_SOURCE_CHUNK ? event_count : JOYSTICK_SOURCE_CHUNK;
+
+		ssize_t bytes_written = write(source->source_fd, events, chunk*sizeof(struct js_event));
+		if(bytes_written < 0)
+		{
+			if(errno == EINTR){
+				continue;
+			}
+
+			/* Drop the SIGPIPE raised by this write. */
+			if(errno == EPIPE && !pipe_pending){
+				const struct timespec zero = {0, 0};
+				sigtimedwait(&pipe_set, NULL, &zero);
+			}
+
+			result = -1;
+			break;
+		}
+
+		events += chunk;
+		event_count -= chunk;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+
+	return result;
+}
+
+void joystick_source_close(struct joystick_source *source)
+{
+	assert(source != NULL);
+
+	if(source->source_stop_fd >= 0)
+	{
+		const uint64_t stop = 1;
+		if(write(source->source_stop_fd, &stop, sizeof stop) < 0){
+			/* Counter can not overflow from one write. */
+		}
+
+		pthread_join(source->source_thread, NULL);
+
+		close(source->source_stop_fd);
+		source->source_stop_fd = -1;
+	}
+
+	if(source->source_fd >= 0){
+		close(source->source_fd);
+		source->source_fd = -1;
+	}
+
+	if(source->source_replay != NULL){
+		munmap((void *)source->source_replay, source->source_replay_size);
+		source->source_replay = NULL;
+	}
+}
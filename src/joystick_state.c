@@ -0,0 +1,184 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "joystick_state.h"
+
+
+void joystick_state_create(struct joystick_state *state, const struct joystick_input_attrib *input_attrib)
+{
+	assert(state != NULL);
+	assert(input_attrib != NULL);
+
+	memset(state, 0, sizeof(struct joystick_state));
+
+	/* Larger devices are only held in part. */
+	state->state_axis_count = input_attrib->joystick_axis_count < JOYSTICK_AXIS_MAX ? input_attrib->joystick_axis_count : JOYSTICK_AXIS_MAX;
+	state->state_button_count = input_attrib->joystick_button_count < JOYSTICK_BUTTON_MAX ? input_attrib->joystick_button_count : JOYSTICK_BUTTON_MAX;
+}
+
+int joystick_device_poll_state(struct joystick_device *device, struct joystick_state *state)
+{
+	assert(device != NULL);
+	assert(state != NULL);
+
+	struct js_event js_event_buffer[JOYSTICK_EVENT_BUFFER_SIZE];
+	int event_count = joystick_device_read(device, js_event_buffer, JOYSTICK_EVENT_BUFFER_SIZE);
+	if(event_count <= 0){
+		return event_count;
+	}
+
+	joystick_device_decode_state(device, js_event_buffer, (size_t)event_count, state);
+	state->state_sequence++;
+
+	return 1;
+}
+
+void joystick_device_decode_state(struct joystick_device *device, const struct js_event *events, size_t event_count, struct joystick_state *state)
+{
+	assert(device != NULL);
+	assert(events != NULL);
+	assert(state != NULL);
+
+	for(size_t i = 0; i < event_count; i++)
+	{
+		const uint8_t number = events[i].number;
+
+		switch(events[i].type & ~JS_EVENT_INIT)
+		{
+			case JS_EVENT_AXIS:
+				if(number < state->state_axis_count){
+					state->state_axis[number] = events[i].value;
+					state->state_event_time = events[i].time;
+				}
+			break;
+
+			case JS_EVENT_BUTTON:
+				if(number < state->state_button_count){
+					const uint32_t bit = 1u << number;
+					state->state_button = events[i].value ? state->state_button | bit : state->state_button & ~bit;
+					state->state_event_time = events[i].time;
+				}
+			break;
+		}
+	}
+}
+
+void joystick_state_from_value(struct joystick_state *state, const struct joystick_input_value *input_value)
+{
+	assert(state != NULL);
+	assert(input_value != NULL);
+
+	for(uint32_t i = 0; i < state->state_axis_count; i++)
+	{
+		float v = input_value->joystick_axis_value[i]*(float)INT16_MAX;
+		v = v < 0.0f ? v - 0.5f : v + 0.5f;
+
+		if(v >= (float)INT16_MAX){
+			state->state_axis[i] = INT16_MAX;
+		}
+		else if(v <= (float)INT16_MIN){
+			state->state_axis[i] = INT16_MIN;
+		}
+		else{
+			state->state_axis[i] = (int16_t)v;
+		}
+	}
+
+	uint32_t button = 0;
+	for(uint32_t i = 0; i < state->state_button_count; i++)
+	{
+		if(input_value->joystick_button_value[i] != 0){
+			button |= 1u << i;
+		}
+	}
+
+	state->state_button = button;
+	state->state_event_time = input_value->joystick_event_time;
+	state->state_sequence++;
+}
+
+void joystick_state_to_value(const struct joystick_state *state, struct joystick_input_value *input_value)
+{
+	assert(state != NULL);
+	assert(input_value != NULL);
+
+	memset(input_value, 0, sizeof(struct joystick_input_value));
+
+	for(uint32_t i = 0; i < state->state_axis_count; i++){
+		input_value->joystick_axis_value[i] = ((float)state->state_axis[i])/((float)INT16_MAX);
+	}
+
+	for(uint32_t i = 0; i < state->state_button_count; i++){
+		input_value->joystick_button_value[i] = (int16_t)((state->state_button >> i) & 1u);
+	}
+
+	input_value->joystick_event_time = state->state_event_time;
+}
+
+void joystick_state_from_value_q15(struct joystick_state *state, const struct joystick_input_value_q15 *input_value)
+{
+	assert(state != NULL);
+	assert(input_value != NULL);
+
+	memcpy(state->state_axis, input_value->joystick_axis_value, state->state_axis_count*sizeof(int16_t));
+
+	uint32_t button = 0;
+	for(uint32_t i = 0; i < state->state_button_count; i++)
+	{
+		if(input_value->joystick_button_value[i] != 0){
+			button |= 1u << i;
+		}
+	}
+
+	state->state_button = button;
+	state->state_event_time = input_value->joystick_event_time;
+	state->state_sequence++;
+}
+
+void joystick_state_to_value_q15(const struct joystick_state *state, struct joystick_input_value_q15 *input_value)
+{
+	assert(state != NULL);
+	assert(input_value != NULL);
+
+	memset(input_value, 0, sizeof(struct joystick_input_value_q15));
+
+	memcpy(input_value->joystick_axis_value, state->state_axis, state->state_axis_count*sizeof(int16_t));
+
+	for(uint32_t i = 0; i < state->state_button_count; i++){
+		input_value->joystick_button_value[i] = (int16_t)((state->state_button >> i) & 1u);
+	}
+
+	input_value->joystick_event_time = state->state_event_time;
+}
+
+int joystick_state_is_equal(const struct joystick_state *a, const struct joystick_state *b)
+{
+	assert(a != NULL);
+	assert(b != NULL);
+
+	if(a->state_button != b->state_button || a->state_axis_count != b->state_axis_count){
+		return -1;
+	}
+
+	return memcmp(a->state_axis, b->state_axis, a->state_axis_count*sizeof(int16_t)) == 0 ? 1 : -1;
+}
+
+uint32_t joystick_state_axis_changed(const struct joystick_state *a, const struct joystick_state *b)
+{
+	assert(a != NULL);
+	assert(b != NULL);
+
+	uint32_t changed = 0;
+
+	/* Unused axes are zero in both. */
+	for(uint32_t i = 0; i < JOYSTICK_AXIS_MAX; i++)
+	{
+		if(a->state_axis[i] != b->state_axis[i]){
+			changed |= 1u << i;
+		}
+	}
+
+	return changed;
+}
@@ -0,0 +1,292 @@
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "joystick_stats.h"
+
+/* Latency buckets per power of two, as bits. */
+#define JOYSTICK_STATS_SUB_BITS 2
+
+
+int joystick_stats_enabled(void)
+{
+#ifdef JOYSTICK_STATS
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+void joystick_stats_create(struct joystick_stats *stats)
+{
+	assert(stats != NULL);
+
+	memset(stats, 0, sizeof(struct joystick_stats));
+}
+
+void joystick_stats_snapshot(const struct joystick_stats *stats, struct joystick_stats_value *value)
+{
+	assert(stats != NULL);
+	assert(value != NULL);
+
+	uint32_t sequence_begin, sequence_end;
+
+	do
+	{
+		sequence_begin = __atomic_load_n(&stats->stats_sequence, __ATOMIC_ACQUIRE);
+		if(sequence_begin & 1){
+			continue;
+		}
+
+		memcpy(value, &stats->stats_value, sizeof(struct joystick_stats_value));
+
+		/* Order the copy before the second sequence load. */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		sequence_end = __atomic_load_n(&stats->stats_sequence, __ATOMIC_RELAXED);
+
+		if(sequence_begin == sequence_end){
+			break;
+		}
+
+	}while(1);
+}
+
+int joystick_device_use_stats(struct joystick_device *device, struct joystick_stats *stats)
+{
+	assert(device != NULL);
+
+	if(!joystick_stats_enabled()){
+		return -1;
+	}
+
+	device->device_stats = stats;
+
+	return 0;
+}
+
+
+uint32_t joystick_stats_bucket(uint64_t latency_us)
+{
+	const uint64_t sub_count = 1 << JOYSTICK_STATS_SUB_BITS;
+
+	if(latency_us < sub_count){
+		return (uint32_t)latency_us;
+	}
+
+	/* Highest set bit, and the bits below it as sub bucket. */
+	const uint32_t exponent = 63 - (uint32_t)__builtin_clzll(latency_us);
+	const uint64_t sub = (latency_us >> (exponent - JOYSTICK_STATS_SUB_BITS)) & (sub_count - 1);
+	const uint64_t bucket = (exponent - JOYSTICK_STATS_SUB_BITS + 1)*sub_count + sub;
+
+	return bucket < JOYSTICK_STATS_LATENCY_BUCKETS ? (uint32_t)bucket : JOYSTICK_STATS_LATENCY_BUCKETS - 1;
+}
+
+uint64_t joystick_stats_bucket_lower(uint32_t bucket)
+{
+	assert(bucket < JOYSTICK_STATS_LATENCY_BUCKETS);
+
+	const uint32_t sub_count = 1 << JOYSTICK_STATS_SUB_BITS;
+
+	if(bucket < sub_count){
+		return bucket;
+	}
+
+	const uint32_t exponent = bucket/sub_count + JOYSTICK_STATS_SUB_BITS - 1;
+	const uint64_t sub = bucket%sub_count;
+
+	return (sub_count + sub) << (exponent - JOYSTICK_STATS_SUB_BITS);
+}
+
+uint64_t joystick_stats_percentile(const struct joystick_stats_value *value, double percentile)
+{
+	assert(value != NULL);
+	assert(percentile >= 0.0 && percentile <= 1.0);
+
+	uint64_t total = 0;
+	for(uint32_t i = 0; i < JOYSTICK_STATS_LATENCY_BUCKETS; i++){
+		total = total + value->value_latency[i];
+	}
+
+	if(total == 0){
+		return 0;
+	}
+
+	/* Rank of the sample, from 1. */
+	uint64_t rank = (uint64_t)(percentile*(double)total + 0.5);
+	rank = rank < 1 ? 1 : rank;
+
+	uint64_t count = 0;
+	for(uint32_t i = 0; i < JOYSTICK_STATS_LATENCY_BUCKETS; i++)
+	{
+		count = count + value->value_latency[i];
+		if(count >= rank){
+			return joystick_stats_bucket_lower(i);
+		}
+	}
+
+	return joystick_stats_bucket_lower(JOYSTICK_STATS_LATENCY_BUCKETS - 1);
+}
+
+
+static uint64_t joystick_stats_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec*UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+}
+
+static void joystick_stats_begin(struct joystick_stats *stats)
+{
+	const uint32_t sequence = stats->stats_sequence;
+
+	__atomic_store_n(&stats->stats_sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void joystick_stats_end(struct joystick_stats *stats)
+{
+	__atomic_store_n(&stats->stats_sequence, stats->stats_sequence + 1, __ATOMIC_RELEASE);
+}
+
+static void joystick_stats_count_read(struct joystick_stats_value *value, size_t byte_count, size_t event_count)
+{
+	value->value_read_count++;
+	value->value_byte_count += byte_count;
+	value->value_event_count += event_count;
+
+	if(event_count == 0){
+		value->value_empty_count++;
+		return;
+	}
+
+	const uint32_t bucket = 63 - (uint32_t)__builtin_clzll(event_count);
+	value->value_read_events[bucket < JOYSTICK_STATS_READ_BUCKETS ? bucket : JOYSTICK_STATS_READ_BUCKETS - 1]++;
+}
+
+/*
+ * Lower the joydev offset by shift milliseconds. Counted latencies grow by
+ * the same amount, and are moved to the bucket of their new value.
+ */
+static void joystick_stats_joydev_shift(struct joystick_stats *stats, uint32_t shift)
+{
+	uint64_t *latency = stats->stats_joydev_latency;
+
+	/* From the top, so every latency is moved to a place already emptied. */
+	for(uint32_t i = JOYSTICK_STATS_JOYDEV_RANGE; i-- > 0;)
+	{
+		const uint64_t count = latency[i];
+		if(count == 0){
+			continue;
+		}
+
+		const uint64_t moved = (uint64_t)i + shift;
+
+		stats->stats_value.value_latency[joystick_stats_bucket((uint64_t)i*1000)] -= count;
+		stats->stats_value.value_latency[joystick_stats_bucket(moved*1000)] += count;
+
+		latency[i] = 0;
+		if(moved < JOYSTICK_STATS_JOYDEV_RANGE){
+			latency[moved] = count;
+		}
+	}
+
+	stats->stats_joydev_offset = stats->stats_joydev_offset - shift;
+}
+
+void joystick_stats_read(struct joystick_stats *stats, size_t byte_count, const struct js_event *events, size_t event_count)
+{
+	assert(stats != NULL);
+	assert(events != NULL || event_count == 0);
+
+	struct joystick_stats_value *value = &stats->stats_value;
+
+	joystick_stats_begin(stats);
+	joystick_stats_count_read(value, byte_count, event_count);
+
+	if(event_count > 0)
+	{
+		const uint32_t now_ms = (uint32_t)(joystick_stats_now()/1000000);
+
+		for(size_t i = 0; i < event_count; i++)
+		{
+			/* Modular, the kernel clock wraps. */
+			const uint32_t difference = now_ms - events[i].time;
+
+			if(!stats->stats_joydev_calibrated){
+				stats->stats_joydev_offset = difference;
+				stats->stats_joydev_calibrated = 1;
+			}
+			else if(difference < stats->stats_joydev_offset){
+				joystick_stats_joydev_shift(stats, stats->stats_joydev_offset - difference);
+			}
+
+			const uint32_t latency_ms = difference - stats->stats_joydev_offset;
+			if(latency_ms < JOYSTICK_STATS_JOYDEV_RANGE){
+				stats->stats_joydev_latency[latency_ms]++;
+			}
+
+			value->value_latency[joystick_stats_bucket((uint64_t)latency_ms*1000)]++;
+		}
+	}
+
+	joystick_stats_end(stats);
+}
+
+void joystick_stats_read_evdev(struct joystick_stats *stats, size_t byte_count, const struct input_event *events, size_t event_count)
+{
+	assert(stats != NULL);
+	assert(events != NULL || event_count == 0);
+
+	struct joystick_stats_value *value = &stats->stats_value;
+
+	joystick_stats_begin(stats);
+	joystick_stats_count_read(value, byte_count, event_count);
+
+	if(event_count > 0)
+	{
+		const uint64_t now_us = joystick_stats_now()/1000;
+
+		for(size_t i = 0; i < event_count; i++)
+		{
+			const uint64_t time_us = (uint64_t)events[i].input_event_sec*1000000 + (uint64_t)events[i].input_event_usec;
+			const uint64_t latency_us = now_us > time_us ? now_us - time_us : 0;
+
+			value->value_latency[joystick_stats_bucket(latency_us)]++;
+		}
+	}
+
+	joystick_stats_end(stats);
+}
+
+void joystick_stats_disconnect(struct joystick_stats *stats)
+{
+	assert(stats != NULL);
+
+	joystick_stats_begin(stats);
+
+	stats->stats_value.value_disconnect_count++;
+	stats->stats_value.value_disconnect_time = joystick_stats_now();
+
+	joystick_stats_end(stats);
+}
+
+void joystick_stats_reconnect(struct joystick_stats *stats)
+{
+	assert(stats != NULL);
+
+	struct joystick_stats_value *value = &stats->stats_value;
+
+	joystick_stats_begin(stats);
+
+	value->value_reconnect_count++;
+
+	if(value->value_disconnect_time != 0){
+		value->value_disconnected_ns += joystick_stats_now() - value->value_disconnect_time;
+		value->value_disconnect_time = 0;
+	}
+
+	joystick_stats_end(stats);
+}
@@ -0,0 +1,272 @@
+#include <assert.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+
+#include "joystick_sysfs.h"
+
+/* Enough words for KEY_MAX with 32 bit words. */
+#define JOYSTICK_SYSFS_BITMAP_WORDS 	32
+
+#define JOYSTICK_SYSFS_WORD_BITS 	(sizeof(unsigned long)*8)
+
+
+/*
+ * Join directory and file name. The directory may lack trailing separator.
+ *
+ * @return Returns 0 on success. -1 if the path does not fit.
+ */
+static int joystick_sysfs_join(char *path, size_t path_size, const char *dir_path, const char *name)
+{
+	const size_t dir_path_length = strlen(dir_path);
+	const char *separator = (dir_path_length > 0 && dir_path[dir_path_length - 1] == '/') ? "" : "/";
+
+	int length = snprintf(path, path_size, "%s%s%s", dir_path, separator, name);
+	if(length < 0 || (size_t)length >= path_size){
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Read small sysfs file into null terminated buffer.
+ *
+ * @return Returns 0 on success. -1 on failure.
+ */
+static int joystick_sysfs_read(const char *path, char *buffer, size_t buffer_size)
+{
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0){
+		return -1;
+	}
+
+	ssize_t bytes_read = read(fd, buffer, buffer_size - 1);
+	close(fd);
+
+	if(bytes_read < 0){
+		return -1;
+	}
+
+	buffer[bytes_read] = '\0';
+	return 0;
+}
+
+/*
+ * Parse capability bitmap. The file holds hex words separated by
+ * space, most significant word first.
+ *
+ * @return Returns number of words parsed, word 0 holds bit 0. -1 on failure.
+ */
+static int joystick_sysfs_bitmap(const char *text, unsigned long *words, size_t word_max)
+{
+	unsigned long parsed[JOYSTICK_SYSFS_BITMAP_WORDS];
+	size_t parsed_count = 0;
+
+	const char *cursor = text;
+	while(1)
+	{
+		while(*cursor == ' '){
+			cursor++;
+		}
+
+		if(*cursor == '\0' || *cursor == '\n'){
+			break;
+		}
+
+		if(parsed_count == JOYSTICK_SYSFS_BITMAP_WORDS){
+			return -1;
+		}
+
+		char *end = NULL;
+		parsed[parsed_count] = strtoul(cursor, &end, 16);
+		if(end == cursor){
+			return -1;
+		}
+
+		parsed_count = parsed_count + 1;
+		cursor = end;
+	}
+
+	if(parsed_count == 0 || parsed_count > word_max){
+		return -1;
+	}
+
+	for(size_t i = 0; i < parsed_count; i++){
+		words[i] = parsed[parsed_count - 1 - i];
+	}
+
+	return (int)parsed_count;
+}
+
+/*
+ * Count set bits in [bit_begin, bit_end).
+ */
+static uint32_t joystick_sysfs_count(const unsigned long *words, size_t word_count, size_t bit_begin, size_t bit_end)
+{
+	uint32_t count = 0;
+
+	for(size_t bit = bit_begin; bit < bit_end; bit++)
+	{
+		const size_t word = bit/JOYSTICK_SYSFS_WORD_BITS;
+		if(word >= word_count){
+			break;
+		}
+
+		if(words[word] & (1UL << (bit%JOYSTICK_SYSFS_WORD_BITS))){
+			count = count + 1;
+		}
+	}
+
+	return count;
+}
+
+int joystick_sysfs_attrib(const char *sysfs_path, const char *dev_path, const char *name, struct joystick_input_attrib *input_attrib)
+{
+	assert(name != NULL);
+	assert(input_attrib != NULL);
+
+	if(sysfs_path == NULL){
+		sysfs_path = JOYSTICK_SYSFS_PATH;
+	}
+
+	if(dev_path == NULL){
+		dev_path = JOYSTICK_SYSFS_DEV_PATH;
+	}
+
+	char entry_path[PATH_MAX];
+	char file_path[PATH_MAX];
+	char buffer[1024];
+
+	if(joystick_sysfs_join(entry_path, sizeof entry_path, sysfs_path, name) < 0){
+		return -1;
+	}
+
+	memset(input_attrib, 0, sizeof(struct joystick_input_attrib));
+
+	/*
+	 * Name as reported by JSIOCGNAME.
+	 */
+	if(joystick_sysfs_join(file_path, sizeof file_path, entry_path, "device/name") < 0
+	|| joystick_sysfs_read(file_path, buffer, sizeof buffer) < 0)
+	{
+		return -1;
+	}
+
+	buffer[strcspn(buffer, "\n")] = '\0';
+	memcpy(input_attrib->joystick_name, buffer, strnlen(buffer, sizeof(input_attrib->joystick_name) - 1));
+
+	/*
+	 * joydev gives every absolute axis an axis number and
+	 * every key from BTN_MISC up to KEY_MAX a button number.
+	 */
+	unsigned long words[JOYSTICK_SYSFS_BITMAP_WORDS];
+	int word_count;
+
+	if(joystick_sysfs_join(file_path, sizeof file_path, entry_path, "device/capabilities/abs") < 0
+	|| joystick_sysfs_read(file_path, buffer, sizeof buffer) < 0
+	|| (word_count = joystick_sysfs_bitmap(buffer, words, JOYSTICK_SYSFS_BITMAP_WORDS)) < 0)
+	{
+		return -1;
+	}
+
+	const uint32_t axis_count = joystick_sysfs_count(words, (size_t)word_count, 0, ABS_CNT);
+
+	if(joystick_sysfs_join(file_path, sizeof file_path, entry_path, "device/capabilities/key") < 0
+	|| joystick_sysfs_read(file_path, buffer, sizeof buffer) < 0
+	|| (word_count = joystick_sysfs_bitmap(buffer, words, JOYSTICK_SYSFS_BITMAP_WORDS)) < 0)
+	{
+		return -1;
+	}
+
+	const uint32_t button_count = joystick_sysfs_count(words, (size_t)word_count, BTN_MISC, KEY_MAX + 1);
+
+	/* Same limits as when the device is opened. */
+	if(axis_count > JOYSTICK_DEVICE_AXIS_MAX || button_count > JOYSTICK_DEVICE_BUTTON_MAX){
+		return -1;
+	}
+
+	input_attrib->joystick_axis_count = (uint8_t)axis_count;
+	input_attrib->joystick_button_count = (uint8_t)button_count;
+
+	if(joystick_sysfs_join((char *)input_attrib->joystick_device_path, sizeof input_attrib->joystick_device_path, dev_path, name) < 0){
+		return -1;
+	}
+
+	return 0;
+}
+
+size_t joystick_sysfs_identify_by_requirement(const char *sysfs_path, const char *dev_path, struct joystick_input_requirement *input_requirement, struct joystick_input_attrib *input_attrib, size_t input_attrib_max)
+{
+	assert(input_requirement != NULL);
+	assert(input_attrib != NULL);
+	assert(input_attrib_max > 0);
+
+	if(sysfs_path == NULL){
+		sysfs_path = JOYSTICK_SYSFS_PATH;
+	}
+
+	if(dev_path == NULL){
+		dev_path = JOYSTICK_SYSFS_DEV_PATH;
+	}
+
+	DIR *dir = opendir(sysfs_path);
+	if(dir == NULL){
+		return 0;
+	}
+
+	size_t joystick_device_found_index = 0;
+	struct dirent *dirent = NULL;
+
+	while((dirent = readdir(dir)) != NULL)
+	{
+		/* Entries in /sys/class/input/ are symbolic links. */
+		if(strncmp(dirent->d_name, "js", 2) != 0){
+			continue;
+		}
+
+		struct joystick_input_attrib curr_input_attrib;
+		const int from_sysfs = joystick_sysfs_attrib(sysfs_path, dev_path, dirent->d_name, &curr_input_attrib) == 0;
+
+		if(!from_sysfs)
+		{
+			/*
+			 * Fall back to asking the driver.
+			 */
+			char device_path[PATH_MAX];
+			if(joystick_sysfs_join(device_path, sizeof device_path, dev_path, dirent->d_name) < 0){
+				continue;
+			}
+
+			if(joystick_device_probe(device_path, &curr_input_attrib) < 0){
+				continue;
+			}
+		}
+
+		if(joystick_input_requirement_satisfied(input_requirement, &curr_input_attrib) < 0){
+			continue;
+		}
+
+		/* The device node is only touched for devices that match. */
+		if(from_sysfs && access((const char *)curr_input_attrib.joystick_device_path, R_OK) < 0){
+			continue;
+		}
+
+		memcpy(&input_attrib[joystick_device_found_index], &curr_input_attrib, sizeof curr_input_attrib);
+		joystick_device_found_index = joystick_device_found_index + 1;
+
+		if(joystick_device_found_index == input_attrib_max){
+			break;
+		}
+	}
+
+	closedir(dir);
+	return joystick_device_found_index;
+}
@@ -0,0 +1,224 @@
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <time.h>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "joystick_wait.h"
+
+
+int joystick_wait_create(struct joystick_wait *wait)
+{
+	assert(wait != NULL);
+
+	wait->wait_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(wait->wait_epoll_fd < 0){
+		return -1;
+	}
+
+	wait->wait_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(wait->wait_event_fd < 0){
+		close(wait->wait_epoll_fd);
+		wait->wait_epoll_fd = -1;
+		return -1;
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof event);
+	event.events = EPOLLIN;
+	event.data.u64 = JOYSTICK_WAIT_TAG_WAKEUP;
+
+	if(epoll_ctl(wait->wait_epoll_fd, EPOLL_CTL_ADD, wait->wait_event_fd, &event) < 0){
+		joystick_wait_destroy(wait);
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_wait_destroy(struct joystick_wait *wait)
+{
+	assert(wait != NULL);
+
+	if(wait->wait_event_fd >= 0){
+		close(wait->wait_event_fd);
+		wait->wait_event_fd = -1;
+	}
+
+	if(wait->wait_epoll_fd >= 0){
+		close(wait->wait_epoll_fd);
+		wait->wait_epoll_fd = -1;
+	}
+
+	return 0;
+}
+
+int joystick_wait_add(struct joystick_wait *wait, int fd, uint64_t tag)
+{
+	assert(wait != NULL);
+	assert(tag != JOYSTICK_WAIT_TAG_WAKEUP);
+
+	if(fd < 0){
+		return -1;
+	}
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof event);
+	event.events = EPOLLIN;
+	event.data.u64 = tag;
+
+	if(epoll_ctl(wait->wait_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0){
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_wait_remove(struct joystick_wait *wait, int fd)
+{
+	assert(wait != NULL);
+
+	if(fd < 0){
+		return -1;
+	}
+
+	if(epoll_ctl(wait->wait_epoll_fd, EPOLL_CTL_DEL, fd, NULL) < 0){
+		return -1;
+	}
+
+	return 0;
+}
+
+int joystick_wait_add_device(struct joystick_wait *wait, struct joystick_device *device, uint64_t tag)
+{
+	assert(wait != NULL);
+	assert(device != NULL);
+
+	if(joystick_device_is_open(device) < 0){
+		return -1;
+	}
+
+	return joystick_wait_add(wait, device->device_fd, tag);
+}
+
+int joystick_wait_remove_device(struct joystick_wait *wait, struct joystick_device *device)
+{
+	assert(wait != NULL);
+	assert(device != NULL);
+
+	return joystick_wait_remove(wait, device->device_fd);
+}
+
+int joystick_wait_wakeup(struct joystick_wait *wait)
+{
+	assert(wait != NULL);
+
+	uint64_t value = 1;
+	ssize_t bytes_written = write(wait->wait_event_fd, &value, sizeof value);
+
+	/* EAGAIN means the counter is saturated, a wakeup is pending anyway. */
+	if((bytes_written < 0) && (errno != EAGAIN)){
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Wait once and collect the tags.
+ *
+ * @return Returns number of tags written, 0 on timeout. -1 on failure or signal, errno tells which.
+ */
+static int joystick_wait_epoll(struct joystick_wait *wait, uint64_t *tags, size_t tag_max, int timeout_ms)
+{
+	struct epoll_event events[JOYSTICK_WAIT_EVENT_MAX];
+	const int event_max = (int)(tag_max < JOYSTICK_WAIT_EVENT_MAX ? tag_max : JOYSTICK_WAIT_EVENT_MAX);
+
+	int event_count = epoll_wait(wait->wait_epoll_fd, events, event_max, timeout_ms);
+	if(event_count < 0){
+		return -1;
+	}
+
+	for(int i = 0; i < event_count; i++)
+	{
+		const uint64_t tag = events[i].data.u64;
+
+		if(tag == JOYSTICK_WAIT_TAG_WAKEUP)
+		{
+			/* Reset the counter so the next wait blocks again. */
+			uint64_t value;
+			ssize_t bytes_read = read(wait->wait_event_fd, &value, sizeof value);
+			(void)bytes_read;
+		}
+
+		tags[i] = tag;
+	}
+
+	return event_count;
+}
+
+int joystick_wait_poll(struct joystick_wait *wait, uint64_t *tags, size_t tag_max, int timeout_ms)
+{
+	assert(wait != NULL);
+	assert(tags != NULL);
+	assert(tag_max > 0);
+
+	int tag_count = joystick_wait_epoll(wait, tags, tag_max, timeout_ms);
+	if(tag_count < 0){
+		return errno == EINTR ? 0 : -1;
+	}
+
+	return tag_count;
+}
+
+int joystick_wait_poll_until(struct joystick_wait *wait, uint64_t *tags, size_t tag_max, const struct timespec *deadline)
+{
+	assert(wait != NULL);
+	assert(tags != NULL);
+	assert(tag_max > 0);
+
+	while(1)
+	{
+		int timeout_ms = -1;
+
+		if(deadline != NULL)
+		{
+			struct timespec now;
+			if(clock_gettime(CLOCK_MONOTONIC, &now) < 0){
+				return -1;
+			}
+
+			/*
+			 * Round remaining time up to whole milliseconds so the
+			 * wait never returns before the deadline.
+			 */
+			int64_t remaining_ns = ((int64_t)deadline->tv_sec - (int64_t)now.tv_sec)*1000000000 + ((int64_t)deadline->tv_nsec - (int64_t)now.tv_nsec);
+			if(remaining_ns < 0){
+				remaining_ns = 0;
+			}
+
+			int64_t remaining_ms = (remaining_ns + 999999)/1000000;
+			timeout_ms = remaining_ms > INT_MAX ? INT_MAX : (int)remaining_ms;
+		}
+
+		int tag_count = joystick_wait_epoll(wait, tags, tag_max, timeout_ms);
+
+		/* Interrupted by a signal, wait again for the time left. */
+		if(tag_count < 0 && errno == EINTR){
+			continue;
+		}
+
+		/* Deadlines further away than INT_MAX milliseconds take more than one wait. */
+		if(tag_count == 0 && timeout_ms == INT_MAX){
+			continue;
+		}
+
+		return tag_count;
+	}
+}
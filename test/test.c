@@ -3,11 +3,14 @@
 #include <stdint.h>
 
 #include <string.h>
+#include <time.h>
 
 
 #define JOYSTICK_LOG_TAG 
 #include "joystick.h"
 #include "joystick_map.h"
+#include "joystick_wait.h"
+#include "joystick_source.h"
 
 
 
@@ -39,6 +42,22 @@ static struct joystick_device joystick_controller;
  */
 static struct joystick_map joystick_controller_map;
 
+/* 
+ * Blocks until the joystick have new input. 
+ */
+static struct joystick_wait joystick_controller_wait;
+
+/* 
+ * Synthetic input when run with -g, no joystick needed. 
+ */
+static struct joystick_source joystick_controller_source;
+
+/*
+ * How often to try reopening a disconnected joystick. 
+ */
+
+#define APP_REOPEN_INTERVAL_MS 1000
+
 /* 
  * Minium rquirement of input device. 
  */
@@ -57,6 +76,7 @@ int main(int args, char *argv[])
 
 	int result = 0;
 	char *joystick_device_path = NULL;
+	int generate = args == 2 && strcmp(argv[1], "-g") == 0;
 
 	/* 
 	 * If no joystick path is passed from command line, then 
@@ -68,7 +88,7 @@ int main(int args, char *argv[])
 	memset(&input_attrib_list, 0, sizeof input_attrib_list);
 
 
-	if(joystick_device_path == NULL)
+	if(joystick_device_path == NULL && !generate)
 	{
 		
 		size_t number_of_joysticks = joystick_device_identify_by_requirement(&joystick_input_req, input_attrib_list, input_attrib_list_count);
@@ -84,28 +104,42 @@ int main(int args, char *argv[])
 
 	
 	if((joystick_device_path == NULL) && (args < 2)){
-		fprintf(stdout, "Usage: %s joystick_device_path  \n", argv[0]);
+		fprintf(stdout, "Usage: %s [joystick_device_path | -g]  \n", argv[0]);
 		exit(EXIT_FAILURE);
-	}else if(args == 2)
+	}else if(args == 2 && !generate)
 	{
 		joystick_device_path = argv[1];
 	}
 
 
-	result = joystick_device_open(&joystick_controller, joystick_device_path);
+	if(generate)
+	{
+		struct joystick_source_config source_config;
+		joystick_source_config_default(&source_config, JOYSTICK_SOURCE_GENERATOR);
+
+		result = joystick_source_open(&joystick_controller_source, &joystick_controller, &source_config);
+	}
+	else{
+		result = joystick_device_open(&joystick_controller, joystick_device_path);
+	}
+
 	if(result < 0){
 		fprintf(stderr, "joystick_device_open(): error \n");
 		exit(EXIT_FAILURE);
 	}
 	else{
 
-		/* Determined by the input joystick HW. */	
-		const uint32_t linear_inputs = joystick_device_axis_count(&joystick_controller);
+		/* Determined by the input joystick HW, polled values hold the first JOYSTICK_MAP_INPUT_MAX axes. */	
+		const uint32_t device_axis_count = joystick_device_axis_count(&joystick_controller);
+		const uint32_t linear_inputs = device_axis_count < JOYSTICK_MAP_INPUT_MAX ? device_axis_count : JOYSTICK_MAP_INPUT_MAX;
 
 		/* Determined by the application requirement. */
 		const uint32_t outputs = APP_INPUTS;
 
-		joystick_map_create(&joystick_controller_map, linear_inputs, outputs);
+		if(joystick_map_create(&joystick_controller_map, linear_inputs, outputs) < 0){
+			fprintf(stderr, "joystick_map_create(): error \n");
+			exit(EXIT_FAILURE);
+		}
 
 		/*
 		 * Assing input index 0 to output index 1,4,5,6
@@ -120,25 +154,62 @@ int main(int args, char *argv[])
 		}
 	}
 
+	result = joystick_wait_create(&joystick_controller_wait);
+	if(result < 0){
+		fprintf(stderr, "joystick_wait_create(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
+	result = joystick_wait_add_device(&joystick_controller_wait, &joystick_controller, 0);
+	if(result < 0){
+		fprintf(stderr, "joystick_wait_add_device(): error \n");
+		exit(EXIT_FAILURE);
+	}
+
 	struct joystick_input_value input_value;
+	memset(&input_value, 0, sizeof input_value);
+
 	while(1)
 	{
-		clock_t time = clock();
 		float output[APP_INPUTS];
 		const uint32_t output_count = APP_INPUTS;
 		
+		/* 
+		 * Sleep until there is input. If the joystick is disconnected,
+		 * wake up periodically and try to reopen it. 
+		 */
+		uint64_t tag;
+		int timeout_ms = joystick_device_is_open(&joystick_controller) < 0 ? APP_REOPEN_INTERVAL_MS : -1;
+		result = joystick_wait_poll(&joystick_controller_wait, &tag, 1, timeout_ms);
+		if(result < 0){
+			fprintf(stderr, "joystick_wait_poll(): error \n");
+			break;
+		}
+
+		if(joystick_device_is_open(&joystick_controller) < 0){
+			result = joystick_device_reopen(&joystick_controller);
+			if(result > 0){
+				result = joystick_wait_add_device(&joystick_controller_wait, &joystick_controller, 0);
+				(void)result;
+			}
+			continue;
+		}
+
+		/* Wall time of poll and translate, not CPU time. */
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
 		
 		result = joystick_device_poll(&joystick_controller, &input_value);
 		if(result < 0){
-			result = joystick_device_reopen(&joystick_controller);
-			(void)result;
+			continue;
 		}
 		else if(result > 0)
 		{
 			joystick_map_translate(&joystick_controller_map, &input_value, output, output_count);
+			clock_gettime(CLOCK_MONOTONIC, &end);
 						
 #if 1
-			float dt = (float)(clock() - time)/(float)CLOCKS_PER_SEC;
+			float dt = (float)(end.tv_sec - start.tv_sec) + (float)(end.tv_nsec - start.tv_nsec)*1e-9f;
 			printf("DT: %f :", dt);
 
 			for(int i = 0; i < APP_INPUTS; i++){
@@ -155,9 +226,14 @@ int main(int args, char *argv[])
 
 	}
 
+	joystick_wait_destroy(&joystick_controller_wait);
 	joystick_map_destroy(&joystick_controller_map);
 	joystick_device_close(&joystick_controller);
 
+	if(generate){
+		joystick_source_close(&joystick_controller_source);
+	}
+
 	
 	return 0;
 }